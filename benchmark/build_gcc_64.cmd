@@ -1 +1 @@
-g++ -o g64.exe main.cpp -O3 -std=c++17 -Wno-attributes -m64 -march=broadwell -mtune=broadwell -lbenchmark -lbenchmark_main -labsl_int128 -labsl_numeric -lshlwapi
+g++ -o g64.exe main.cpp -O3 -std=c++17 -Wno-attributes -m64 -march=broadwell -mtune=broadwell -lbenchmark -lshlwapi
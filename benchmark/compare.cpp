@@ -0,0 +1,367 @@
+
+// MIT License
+//
+// Copyright (c) 2018 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+
+// Compares the JSON output of two runs of the benchmark, a baseline and a current run, per
+// mode, algorithm and range width (or profile). A benchmark regressed (improved) if its mean
+// cpu time grew (shrank) by more than the tolerance, and the difference is significant,
+// Welch's t over the repetitions beyond z (by default 5%, 3).
+
+
+// A JSON value, as far as the benchmark output needs one.
+struct json {
+
+    enum class kind { null, boolean, number, string, array, object };
+
+    [[ nodiscard ]] const json * find ( std::string_view key ) const noexcept {
+        for ( const auto & [ k, v ] : members ) {
+            if ( k == key ) {
+                return &v;
+            }
+        }
+        return nullptr;
+    }
+    [[ nodiscard ]] std::string_view string_of ( std::string_view key ) const noexcept {
+        const json * v = find ( key );
+        return v and kind::string == v->type ? std::string_view ( v->text ) : std::string_view ( );
+    }
+    [[ nodiscard ]] double number_of ( std::string_view key, double otherwise = 0.0 ) const noexcept {
+        const json * v = find ( key );
+        return v and kind::number == v->type ? v->number : otherwise;
+    }
+
+    kind type = kind::null;
+    double number = 0.0;
+    std::string text;
+    std::vector<json> elements;
+    std::vector<std::pair<std::string, json>> members;
+};
+
+class json_parser {
+
+    public:
+
+    explicit json_parser ( std::string_view s_ ) noexcept :
+        s ( s_ ) { }
+
+    // Parses the document, returns false on a syntax error.
+    [[ nodiscard ]] bool parse ( json & v ) {
+        return value ( v ) and ( skip ( ), p == s.size ( ) );
+    }
+
+    private:
+
+    void skip ( ) noexcept {
+        while ( p < s.size ( ) and ( ' ' == s [ p ] or '\t' == s [ p ] or '\n' == s [ p ] or '\r' == s [ p ] ) ) {
+            ++p;
+        }
+    }
+
+    [[ nodiscard ]] bool literal ( std::string_view l ) noexcept {
+        if ( s.substr ( p, l.size ( ) ) != l ) {
+            return false;
+        }
+        p += l.size ( );
+        return true;
+    }
+
+    [[ nodiscard ]] bool string ( std::string & out ) {
+        if ( p == s.size ( ) or '"' != s [ p++ ] ) {
+            return false;
+        }
+        while ( p < s.size ( ) and '"' != s [ p ] ) {
+            char c = s [ p++ ];
+            if ( '\\' == c ) {
+                if ( p == s.size ( ) ) {
+                    return false;
+                }
+                switch ( c = s [ p++ ] ) {
+                    case 'n': c = '\n'; break;
+                    case 't': c = '\t'; break;
+                    case 'r': c = '\r'; break;
+                    case 'b': c = '\b'; break;
+                    case 'f': c = '\f'; break;
+                    case 'u': p += 4; c = '?'; break; // not in the names of benchmarks.
+                    default: break;
+                }
+            }
+            out.push_back ( c );
+        }
+        return p++ < s.size ( );
+    }
+
+    [[ nodiscard ]] bool value ( json & v ) {
+        skip ( );
+        if ( p == s.size ( ) ) {
+            return false;
+        }
+        switch ( s [ p ] ) {
+            case '{': {
+                v.type = json::kind::object;
+                ++p;
+                skip ( );
+                if ( p < s.size ( ) and '}' == s [ p ] ) {
+                    ++p;
+                    return true;
+                }
+                do {
+                    skip ( );
+                    std::pair<std::string, json> m;
+                    if ( not string ( m.first ) or ( skip ( ), not literal ( ":" ) ) or not value ( m.second ) ) {
+                        return false;
+                    }
+                    v.members.push_back ( std::move ( m ) );
+                    skip ( );
+                } while ( literal ( "," ) );
+                return literal ( "}" );
+            }
+            case '[': {
+                v.type = json::kind::array;
+                ++p;
+                skip ( );
+                if ( p < s.size ( ) and ']' == s [ p ] ) {
+                    ++p;
+                    return true;
+                }
+                do {
+                    v.elements.emplace_back ( );
+                    if ( not value ( v.elements.back ( ) ) ) {
+                        return false;
+                    }
+                    skip ( );
+                } while ( literal ( "," ) );
+                return literal ( "]" );
+            }
+            case '"':
+                v.type = json::kind::string;
+                return string ( v.text );
+            case 't':
+                v.type = json::kind::boolean, v.number = 1.0;
+                return literal ( "true" );
+            case 'f':
+                v.type = json::kind::boolean;
+                return literal ( "false" );
+            case 'n':
+                return literal ( "null" );
+            default: {
+                // from_chars ( double ) is not in every standard library yet.
+                const std::size_t first = p;
+                while ( p < s.size ( ) and std::string_view ( "+-0123456789.eE" ).find ( s [ p ] ) != std::string_view::npos ) {
+                    ++p;
+                }
+                std::istringstream in ( std::string ( s.substr ( first, p - first ) ) );
+                in.imbue ( std::locale::classic ( ) );
+                v.type = json::kind::number;
+                return p > first and static_cast<bool> ( in >> v.number );
+            }
+        }
+    }
+
+    std::string_view s;
+    std::size_t p = 0;
+};
+
+
+// The mean and standard deviation of the cpu time (in ns) of a benchmark, over its repetitions.
+struct sample {
+    double mean = 0.0, sd = 0.0, n = 0.0;
+};
+
+[[ nodiscard ]] double to_ns ( double t, std::string_view unit ) noexcept {
+    return "us" == unit ? t * 1e3 : "ms" == unit ? t * 1e6 : "s" == unit ? t * 1e9 : t;
+}
+
+// Reads the benchmarks of a JSON file, by run name (f.e. bounded_rand/fast/7/repeats:4), from
+// the aggregates (mean and stddev), or else from the repetitions.
+[[ nodiscard ]] bool read ( const char * path, std::map<std::string, sample> & samples ) {
+    std::ifstream file ( path, std::ios::binary );
+    if ( not file ) {
+        std::cerr << "compare: cannot open " << path << '\n';
+        return false;
+    }
+    const std::string text { std::istreambuf_iterator<char> ( file ), std::istreambuf_iterator<char> ( ) };
+    json document;
+    const json * benchmarks = nullptr;
+    if ( not json_parser ( text ).parse ( document ) or not ( benchmarks = document.find ( "benchmarks" ) ) ) {
+        std::cerr << "compare: " << path << " is not the JSON output of a benchmark\n";
+        return false;
+    }
+    std::map<std::string, std::vector<double>> repetitions;
+    for ( const json & b : benchmarks->elements ) {
+        const std::string name ( b.string_of ( "run_name" ).empty ( ) ? b.string_of ( "name" ) : b.string_of ( "run_name" ) );
+        const double t = to_ns ( b.number_of ( "cpu_time" ), b.string_of ( "time_unit" ) );
+        if ( "aggregate" == b.string_of ( "run_type" ) ) {
+            sample & s = samples [ name ];
+            s.n = b.number_of ( "repetitions", 1.0 );
+            if ( "mean" == b.string_of ( "aggregate_name" ) ) {
+                s.mean = t;
+            }
+            else if ( "stddev" == b.string_of ( "aggregate_name" ) ) {
+                s.sd = t;
+            }
+        }
+        else {
+            repetitions [ name ].push_back ( t );
+        }
+    }
+    for ( const auto & [ name, times ] : repetitions ) {
+        if ( samples.count ( name ) ) {
+            continue;
+        }
+        sample & s = samples [ name ];
+        s.n = static_cast<double> ( times.size ( ) );
+        for ( const double t : times ) {
+            s.mean += t / s.n;
+        }
+        for ( const double t : times ) {
+            s.sd += ( t - s.mean ) * ( t - s.mean );
+        }
+        s.sd = times.size ( ) > 1 ? std::sqrt ( s.sd / ( s.n - 1.0 ) ) : 0.0;
+    }
+    return true;
+}
+
+// The sort key of a run name, <mode>/<algorithm>/<range>[/...], the benchmark (mode and
+// algorithm) and the range, the width (numeric, ordered as such) or the profile (mixed).
+struct key_type {
+    std::string benchmark;
+    int width = 0;
+    std::string profile;
+
+    [[ nodiscard ]] bool operator< ( const key_type & rhs ) const noexcept {
+        return std::tie ( benchmark, width, profile ) < std::tie ( rhs.benchmark, rhs.width, rhs.profile );
+    }
+    [[ nodiscard ]] std::string range ( ) const {
+        return profile.empty ( ) ? std::to_string ( width ) : profile;
+    }
+};
+
+// Splits a run name into its key.
+[[ nodiscard ]] key_type split ( const std::string & name ) {
+    const std::size_t a = name.find ( '/' ), b = name.find ( '/', a + 1 );
+    if ( std::string::npos == a or std::string::npos == b ) {
+        return { name, 0, { } };
+    }
+    const std::size_t c = std::min ( name.find ( '/', b + 1 ), name.size ( ) );
+    key_type key { name.substr ( 0, b ), 0, { } };
+    const auto [ p, ec ] = std::from_chars ( name.data ( ) + b + 1, name.data ( ) + c, key.width );
+    if ( ec != std::errc { } or p != name.data ( ) + c ) {
+        key.profile = name.substr ( b + 1, c - b - 1 );
+    }
+    return key;
+}
+
+void usage ( ) {
+    std::cout << "usage: compare [--tolerance f] [--z f] baseline.json current.json\n"
+                 "    flags the benchmarks that became slower (faster) by more than the tolerance (default\n"
+                 "    0.05, 5%), if Welch's t over the repetitions is beyond z (default 3).\n";
+}
+
+
+int main ( int argc, char ** argv ) {
+
+    double tolerance = 0.05, z = 3.0;
+    std::vector<const char *> paths;
+    for ( int i = 1; i < argc; ++i ) {
+        const std::string_view arg = argv [ i ];
+        if ( ( "--tolerance" == arg or "--z" == arg ) and i + 1 < argc ) {
+            ( "--z" == arg ? z : tolerance ) = std::atof ( argv [ ++i ] );
+        }
+        else {
+            paths.push_back ( argv [ i ] );
+        }
+    }
+    std::map<std::string, sample> baseline, current;
+    if ( paths.size ( ) != 2 ) {
+        usage ( );
+        return EXIT_FAILURE;
+    }
+    if ( not read ( paths [ 0 ], baseline ) or not read ( paths [ 1 ], current ) ) {
+        return EXIT_FAILURE;
+    }
+
+    // By mode and algorithm, then by width (or profile).
+    std::map<key_type, std::string> order;
+    for ( const auto & [ name, s ] : current ) {
+        order.emplace ( split ( name ), name );
+    }
+    int regressions = 0, improvements = 0, unchanged = 0, missing = 0;
+    std::cout << std::left << std::setw ( 28 ) << "benchmark" << std::right << std::setw ( 12 ) << "range" << std::setw ( 14 ) << "baseline ns"
+              << std::setw ( 14 ) << "current ns" << std::setw ( 10 ) << "change" << std::setw ( 9 ) << "t" << '\n';
+    std::cout << std::fixed;
+    for ( const auto & [ key, name ] : order ) {
+        const sample & c = current [ name ];
+        const auto it = baseline.find ( name );
+        std::cout << std::left << std::setw ( 28 ) << key.benchmark << std::right << std::setw ( 12 ) << key.range ( );
+        if ( baseline.end ( ) == it ) {
+            std::cout << std::setw ( 14 ) << '-' << std::setw ( 14 ) << std::setprecision ( 2 ) << c.mean << "    not in the baseline\n";
+            ++missing;
+            continue;
+        }
+        const sample & b = it->second;
+        const double change = c.mean / b.mean - 1.0, se = std::sqrt ( b.sd * b.sd / std::max ( b.n, 1.0 ) + c.sd * c.sd / std::max ( c.n, 1.0 ) );
+        const double t = se > 0.0 ? ( c.mean - b.mean ) / se : ( c.mean > b.mean ? HUGE_VAL : c.mean < b.mean ? -HUGE_VAL : 0.0 );
+        std::cout << std::setw ( 14 ) << std::setprecision ( 2 ) << b.mean << std::setw ( 14 ) << c.mean << std::setw ( 9 ) << std::showpos
+                  << std::setprecision ( 1 ) << 100.0 * change << '%' << std::setw ( 9 ) << t << std::noshowpos;
+        if ( change > tolerance and t > z ) {
+            std::cout << "  regression\n";
+            ++regressions;
+        }
+        else if ( change < -tolerance and t < -z ) {
+            std::cout << "  improvement\n";
+            ++improvements;
+        }
+        else {
+            std::cout << '\n';
+            ++unchanged;
+        }
+    }
+    for ( const auto & [ name, s ] : baseline ) {
+        if ( not current.count ( name ) ) {
+            std::cout << name << " not in the current run\n";
+            ++missing;
+        }
+    }
+    std::cout << regressions << " regressions, " << improvements << " improvements, " << unchanged << " unchanged, " << missing << " missing" << std::endl;
+
+    return regressions ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,412 @@
+
+// MIT License
+//
+// Copyright (c) 2018 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../uid_fast/bucket_test.hpp"
+#include "../uid_fast/splitmix.hpp"
+#include "../uid_fast/statistics.hpp"
+#include "../uid_fast/uniform_int_distribution_fast.hpp"
+
+// The other libraries, where available, UID_STANDARD_LIBRARY_ONLY (the libc++ build, as Boost
+// and Abseil are built against the default standard library) leaves only std.
+
+#if ! defined ( UID_STANDARD_LIBRARY_ONLY ) && __has_include ( <boost/random/uniform_int_distribution.hpp> )
+    #include <boost/random/uniform_int_distribution.hpp>
+    #define HAVE_BOOST 1
+#else
+    #define HAVE_BOOST 0
+#endif
+
+#if ! defined ( UID_STANDARD_LIBRARY_ONLY ) && __has_include ( <absl/random/distributions.h> )
+    #include <absl/random/distributions.h>
+    #define HAVE_ABSL 1
+#else
+    #define HAVE_ABSL 0
+#endif
+
+#if ! defined ( UID_STANDARD_LIBRARY_ONLY ) && __has_include ( <pcg_random.hpp> )
+    #include <pcg_random.hpp>
+    #define HAVE_PCG 1
+#else
+    #define HAVE_PCG 0
+#endif
+
+#if defined ( _LIBCPP_VERSION )
+    #define STANDARD_LIBRARY "libc++"
+#elif defined ( __GLIBCXX__ )
+    #define STANDARD_LIBRARY "libstdc++"
+#elif defined ( _MSC_VER )
+    #define STANDARD_LIBRARY "msvc-stl"
+#else
+    #define STANDARD_LIBRARY "std"
+#endif
+
+
+// Compares uniform_int_distribution_fast (and ext::bounded) against the uniform integer
+// distributions of other libraries, the std::uniform_int_distribution of the standard library
+// (libstdc++, libc++ from a separate build), Boost.Random, absl::Uniform and PCG's
+// bounded_rand, over the range widths, in two workloads, micro (draws into a buffer, per
+// range) and macro (the Bucket-Test). All libraries draw from the same splitmix64 streams,
+// per width and workload. The report ranks the libraries per workload and width.
+
+using result_type = std::uint64_t;
+
+#if HAVE_ABSL
+// absl::Uniform over [ a, b ], as a distribution.
+struct absl_uniform {
+    using result_type = ::result_type;
+    absl_uniform ( result_type a_, result_type b_ ) noexcept : a ( a_ ), b ( b_ ) { }
+    template<typename Gen>
+    [[ nodiscard ]] result_type operator ( ) ( Gen & gen ) {
+        return absl::Uniform ( absl::IntervalClosedClosed, gen, a, b );
+    }
+    result_type a, b;
+};
+#endif
+
+#if HAVE_PCG
+// pcg_extras::bounded_rand over [ a, b ] (b - a + 1 less than 2^64), as a distribution.
+struct pcg_bounded_rand {
+    using result_type = ::result_type;
+    pcg_bounded_rand ( result_type a_, result_type b_ ) noexcept : a ( a_ ), range ( b_ - a_ + 1 ) { }
+    template<typename Gen>
+    [[ nodiscard ]] result_type operator ( ) ( Gen & gen ) {
+        return a + pcg_extras::bounded_rand ( gen, range );
+    }
+    result_type a, range;
+};
+#endif
+
+struct library {
+    std::string_view name;
+    bt::kernel_type kernel;
+};
+
+const library libraries [ ] = {
+    { STANDARD_LIBRARY, bt::kernel_of<std::uniform_int_distribution<result_type>> },
+#if ! defined ( UID_STANDARD_LIBRARY_ONLY )
+    { "uid_fast", bt::kernel_of<ext::uniform_int_distribution_fast<result_type>> },
+    { "bounded", { &bt::count_bounded<result_type>, &bt::fill_bounded<result_type>, &bt::latency_bounded<result_type> } },
+#endif
+#if HAVE_BOOST
+    { "boost", bt::kernel_of<boost::random::uniform_int_distribution<result_type>> },
+#endif
+#if HAVE_ABSL
+    { "absl", bt::kernel_of<absl_uniform> },
+#endif
+#if HAVE_PCG
+    { "pcg", bt::kernel_of<pcg_bounded_rand> },
+#endif
+};
+
+// A measurement, of a library, in a workload (micro or macro), at a range width.
+struct row {
+    std::string workload;
+    int width = 0;
+    std::string name;
+    double ns = 0.0, cycles = 0.0; // per draw.
+};
+
+struct settings {
+    int first = 1, last = 63, last_macro = 24; // the widths, the macro workload up to last_macro.
+    bool probe = false;                         // ranges 2^(w-1) + 1, instead of 2^w.
+    std::uint64_t micro_draws = std::uint64_t { 1 } << 20, macro_draws = std::uint64_t { 1 } << 24, seed = 123;
+    int repetitions = 5;
+    unsigned threads = std::max ( std::thread::hardware_concurrency ( ), 1u );
+};
+
+[[ nodiscard ]] std::uint64_t range_of ( const settings & s, int width ) noexcept {
+    return s.probe ? ( std::uint64_t { 1 } << ( width - 1 ) ) + 1 : std::uint64_t { 1 } << width;
+}
+
+// Times f ( ) repetitions times, returns the median ns and cycles.
+template<typename F>
+[[ nodiscard ]] std::pair<double, double> median_time ( int repetitions, F f ) {
+    std::vector<std::pair<double, double>> times;
+    for ( int r = 0; r < repetitions; ++r ) {
+        const auto start = std::chrono::steady_clock::now ( );
+        const std::uint64_t cycles = sf::cycles ( );
+        f ( );
+        times.emplace_back ( std::chrono::duration<double, std::nano> ( std::chrono::steady_clock::now ( ) - start ).count ( ), static_cast<double> ( sf::cycles ( ) - cycles ) );
+    }
+    std::nth_element ( times.begin ( ), times.begin ( ) + times.size ( ) / 2, times.end ( ) );
+    return times [ times.size ( ) / 2 ];
+}
+
+// The micro workload, micro_draws draws into a buffer of 4096 values, from a splitmix64
+// seeded with seed (every repetition and every library).
+[[ nodiscard ]] row micro ( const settings & s, const library & l, int width ) {
+    std::vector<std::uint64_t> buffer ( 4096 );
+    std::uint64_t sink = 0;
+    const auto [ ns, cycles ] = median_time ( s.repetitions, [ & ] ( ) {
+        bt::generator gen ( s.seed );
+        for ( std::uint64_t draws = s.micro_draws; draws; ) {
+            const std::uint64_t n = std::min<std::uint64_t> ( draws, buffer.size ( ) );
+            l.kernel.fill ( gen, range_of ( s, width ), n, buffer.data ( ) );
+            sink += buffer [ 0 ];
+            draws -= n;
+        }
+    } );
+    volatile std::uint64_t keep = sink;
+    ( void ) keep;
+    return { "micro", width, std::string ( l.name ), ns / s.micro_draws, cycles / s.micro_draws };
+}
+
+// The macro workload, the Bucket-Test of macro_draws draws (the streams split off seed),
+// partitioned beyond 2^20 buckets.
+[[ nodiscard ]] row macro ( const settings & s, const library & l, int width ) {
+    bt::options o;
+    o.range = range_of ( s, width );
+    o.draws = s.macro_draws;
+    o.seed = s.seed;
+    o.threads = s.threads;
+    o.partitioned = o.range > ( std::uint64_t { 1 } << 20 );
+    std::uint64_t sink = 0;
+    const auto [ ns, cycles ] = median_time ( s.repetitions, [ & ] ( ) { sink += bt::run ( o, l.kernel ) [ 0 ]; } );
+    volatile std::uint64_t keep = sink;
+    ( void ) keep;
+    return { "macro", width, std::string ( l.name ), ns / s.macro_draws, cycles / s.macro_draws };
+}
+
+// Writes the rows as csv, workload,width,library,ns,cycles.
+void write ( std::ostream & out, const std::vector<row> & rows ) {
+    for ( const row & r : rows ) {
+        out << r.workload << ',' << r.width << ',' << r.name << ',' << r.ns << ',' << r.cycles << '\n';
+    }
+}
+
+// Reads the rows of a csv file, as written by write ( ), the first row of a library at a
+// width (in a workload) counts.
+[[ nodiscard ]] bool read ( const char * path, std::vector<row> & rows ) {
+    std::ifstream in ( path );
+    if ( not in ) {
+        std::cerr << "compare_libraries: can't read " << path << '\n';
+        return false;
+    }
+    for ( std::string line; std::getline ( in, line ); ) {
+        std::istringstream fields ( line );
+        row r;
+        std::string width, ns, cycles;
+        if ( std::getline ( fields, r.workload, ',' ) and std::getline ( fields, width, ',' ) and std::getline ( fields, r.name, ',' ) and
+             std::getline ( fields, ns, ',' ) and std::getline ( fields, cycles ) ) {
+            r.width = std::atoi ( width.c_str ( ) );
+            r.ns = std::atof ( ns.c_str ( ) );
+            r.cycles = std::atof ( cycles.c_str ( ) );
+            const bool known = std::any_of ( rows.begin ( ), rows.end ( ), [ & r ] ( const row & o ) {
+                return o.workload == r.workload and o.width == r.width and o.name == r.name;
+            } );
+            if ( not known ) {
+                rows.push_back ( std::move ( r ) );
+            }
+        }
+    }
+    return true;
+}
+
+// Prints the ranking (fastest first) per workload and width, followed by the number of
+// widths every library is fastest at and its mean slow-down against the fastest.
+void report ( std::ostream & out, const std::vector<row> & rows ) {
+    std::map<std::string, std::map<int, std::vector<const row *>>> ranks;
+    for ( const row & r : rows ) {
+        ranks [ r.workload ] [ r.width ].push_back ( &r );
+    }
+    out << std::fixed;
+    for ( auto & [ workload, widths ] : ranks ) {
+        out << workload << ", ns (cycles) per draw, fastest first\n";
+        std::map<std::string, std::pair<int, double>> summary; // wins, sum of slow-downs.
+        for ( auto & [ width, ranked ] : widths ) {
+            std::stable_sort ( ranked.begin ( ), ranked.end ( ), [ ] ( const row * a, const row * b ) { return a->ns < b->ns; } );
+            out << std::setw ( 5 ) << width;
+            for ( const row * r : ranked ) {
+                out << "  " << std::setw ( 10 ) << r->name << ' ' << std::setw ( 7 ) << std::setprecision ( 2 ) << r->ns << " (" << std::setprecision ( 1 ) << r->cycles << ')';
+                summary [ r->name ].second += r->ns / ranked.front ( )->ns - 1.0;
+            }
+            ++summary [ ranked.front ( )->name ].first;
+            out << '\n';
+        }
+        for ( const auto & [ name, s ] : summary ) {
+            out << "    " << std::setw ( 10 ) << name << " fastest at " << s.first << " of " << widths.size ( ) << " widths, mean slow-down "
+                << std::setprecision ( 1 ) << 100.0 * s.second / widths.size ( ) << "%\n";
+        }
+    }
+}
+
+// Parses an unsigned integer, or a power of 2 as 2^k.
+template<typename T>
+[[ nodiscard ]] bool parse ( std::string_view s, T & value ) noexcept {
+    const bool power = s.size ( ) > 2 and s.substr ( 0, 2 ) == "2^";
+    if ( power ) {
+        s.remove_prefix ( 2 );
+    }
+    T v = 0;
+    const auto [ p, ec ] = std::from_chars ( s.data ( ), s.data ( ) + s.size ( ), v );
+    if ( ec != std::errc { } or p != s.data ( ) + s.size ( ) or ( power and v >= static_cast<T> ( sizeof ( T ) * 8 ) ) ) {
+        return false;
+    }
+    value = power ? T { 1 } << v : v;
+    return true;
+}
+
+void usage ( ) {
+    std::cout << "usage: compare_libraries [--widths first..last] [--macro-widths last] [--probe] [--micro-draws n] [--macro-draws n]\n"
+                 "                         [--repetitions n] [--threads n] [--seed n] [--out file.csv] [--report file.csv ...]\n"
+                 "    n is an unsigned integer, or a power of 2, as in 2^24.\n"
+                 "    measures " STANDARD_LIBRARY
+#if ! defined ( UID_STANDARD_LIBRARY_ONLY )
+                 ", uid_fast, bounded"
+#endif
+#if HAVE_BOOST
+                 ", boost"
+#endif
+#if HAVE_ABSL
+                 ", absl"
+#endif
+#if HAVE_PCG
+                 ", pcg"
+#endif
+                 " over the ranges 2^w (2^(w-1) + 1 with --probe)\n"
+                 "    of the widths w (1..63), in the micro and (up to width 24) the macro workload, ranks them.\n"
+                 "    --out writes the rows to file.csv, --report ranks the rows of files (f.e. of the libc++ build).\n";
+}
+
+int main ( int argc, char ** argv ) {
+
+    settings s;
+    const char * out_path = nullptr;
+    std::vector<const char *> reports;
+
+    for ( int i = 1; i < argc; ++i ) {
+        const std::string_view arg = argv [ i ];
+        if ( "--probe" == arg ) {
+            s.probe = true;
+            continue;
+        }
+        if ( i + 1 == argc ) {
+            usage ( );
+            return EXIT_FAILURE;
+        }
+        const std::string_view val = argv [ ++i ];
+        bool ok = true;
+        if ( "--out" == arg ) {
+            out_path = argv [ i ];
+        }
+        else if ( "--report" == arg ) {
+            for ( reports.push_back ( argv [ i ] ); i + 1 < argc and argv [ i + 1 ] [ 0 ] != '-'; ) {
+                reports.push_back ( argv [ ++i ] );
+            }
+        }
+        else if ( "--widths" == arg ) {
+            const std::size_t dots = val.find ( ".." );
+            ok = std::string_view::npos != dots and std::from_chars ( val.data ( ), val.data ( ) + dots, s.first ).ec == std::errc { } and
+                 std::from_chars ( val.data ( ) + dots + 2, val.data ( ) + val.size ( ), s.last ).ec == std::errc { };
+        }
+        else if ( "--macro-widths" == arg ) {
+            ok = parse ( val, s.last_macro );
+        }
+        else if ( "--micro-draws" == arg ) {
+            ok = parse ( val, s.micro_draws );
+        }
+        else if ( "--macro-draws" == arg ) {
+            ok = parse ( val, s.macro_draws );
+        }
+        else if ( "--repetitions" == arg ) {
+            ok = parse ( val, s.repetitions );
+        }
+        else if ( "--threads" == arg ) {
+            ok = parse ( val, s.threads );
+        }
+        else if ( "--seed" == arg ) {
+            ok = parse ( val, s.seed );
+        }
+        else {
+            ok = false;
+        }
+        if ( not ok ) {
+            usage ( );
+            return EXIT_FAILURE;
+        }
+    }
+    if ( s.first < 1 or s.last > 63 or s.first > s.last or s.last_macro > 32 or s.repetitions < 1 or not s.micro_draws or not s.macro_draws or not s.threads ) {
+        usage ( );
+        return EXIT_FAILURE;
+    }
+
+    std::vector<row> rows;
+    if ( not reports.empty ( ) ) {
+        for ( const char * path : reports ) {
+            if ( not read ( path, rows ) ) {
+                return EXIT_FAILURE;
+            }
+        }
+        report ( std::cout, rows );
+        return EXIT_SUCCESS;
+    }
+
+    for ( int width = s.first; width <= s.last; ++width ) {
+        for ( const library & l : libraries ) {
+            rows.push_back ( micro ( s, l, width ) );
+        }
+    }
+    for ( int width = s.first; width <= std::min ( s.last, s.last_macro ); ++width ) {
+        for ( const library & l : libraries ) {
+            rows.push_back ( macro ( s, l, width ) );
+        }
+    }
+    if ( out_path ) {
+        std::ofstream out ( out_path );
+        write ( out, rows );
+        if ( not out ) {
+            std::cerr << "compare_libraries: can't write " << out_path << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+    report ( std::cout, rows );
+
+    return EXIT_SUCCESS;
+}
+
+
+// macro cleanup
+
+#undef HAVE_BOOST
+#undef HAVE_ABSL
+#undef HAVE_PCG
+#undef STANDARD_LIBRARY
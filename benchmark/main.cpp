@@ -23,17 +23,19 @@
 
 #define _HAS_EXCEPTIONS 0
 
-#include <intrin.h>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
 
+#include <algorithm>
 #include <iostream>
 #include <limits>
 #include <random>
+#include <string>
+#include <string_view>
 #include <type_traits>
-
-// __builtin_expect
+#include <utility>
+#include <vector>
 
 #include <benchmark/benchmark.h>
 
@@ -41,8 +43,19 @@
     #pragma comment ( lib, "Shlwapi.lib" )
 #endif
 
+#include "../uid_fast/bernoulli_fast.hpp"
+#include "../uid_fast/buffered_uniform_int.hpp"
+#include "../uid_fast/fastrange.hpp"
+#include "../uid_fast/lookahead_index.hpp"
+#include "../uid_fast/random_string.hpp"
 #include "../uid_fast/splitmix.hpp"
+#include "../uid_fast/statistics.hpp"
+#include "../uid_fast/uniform_index_distribution.hpp"
+#include "../uid_fast/uniform_int_batch.hpp"
 #include "../uid_fast/uniform_int_distribution_fast.hpp"
+#include "../uid_fast/uniform_int_producer.hpp"
+#include "../uid_fast/uniform_interval_distribution.hpp"
+#include "../uid_fast/uniform_real_distribution_fast.hpp"
 
 #if UINTPTR_MAX == 0xFFFF'FFFF
 #define M32 1
@@ -54,12 +67,7 @@
 #error funny pointers detected
 #endif
 
-#if M32
-    #define generator splitmix64
-    #include <absl/numeric/int128.h>
-#else
-    #define generator splitmix64
-#endif
+using generator = splitmix64;
 
 #if defined ( _WIN32 ) && ! ( defined ( __clang__ ) || defined ( __GNUC__ ) ) // MSVC and not clang or gcc on windows.
     #include <intrin.h>
@@ -118,16 +126,8 @@
     #endif
 #endif
 
-
-#if GNU
-template<typename T>
-static void do_not_optimize ( T * p ) {
-    asm volatile ( "" : : "g"(p) : "memory" );
-}
-static void clobber_memory ( ) {
-    asm volatile ( "" : : : "memory" );
-}
-#endif
+#define STR_( x ) #x
+#define STR( x ) STR_( x )
 
 
 template<typename Rng, typename Type>
@@ -141,29 +141,34 @@ Type br_fast ( Rng & rng, Type range ) NOEXCEPT {
 }
 
 template<typename Rng, typename Type>
-Type br_debiased_div ( Rng & rng, Type range ) NOEXCEPT {
-    const Type divisor = ( ( 0 - range ) / range ) + 1;
-    if ( divisor == 0 ) {
-        return 0;
-    }
-    while ( true ) {
-        Type val = rng ( ) / divisor;
-        if ( val < range ) {
-            return val;
-        }
-    }
+Type br_bounded ( Rng & rng, Type range ) NOEXCEPT {
+    return ext::bounded ( rng, range );
 }
 
+// The library algorithms, ext::algorithm::*, on the bare engine.
+#define BR_POLICY( name ) \
+template<typename Rng, typename Type> \
+Type br_##name ( Rng & rng, Type range ) NOEXCEPT { \
+    return ext::algorithm::name::generate ( rng, range ); \
+}
+
+BR_POLICY ( lemire )
+BR_POLICY ( lemire_oneill )
+BR_POLICY ( canon )
+BR_POLICY ( bitmask )
+BR_POLICY ( debiased_div )
+BR_POLICY ( modx1 )
+BR_POLICY ( modx1_bopt )
+BR_POLICY ( modx1_mopt )
+BR_POLICY ( debiased_modx2 )
+BR_POLICY ( modx2_topt )
+BR_POLICY ( modx2_topt_bopt )
+BR_POLICY ( modx2_topt_mopt )
+BR_POLICY ( modx2_topt_moptx2 )
+
 template<typename Rng, typename Type>
-Type br_bitmask ( Rng & rng, Type range ) NOEXCEPT {
-    --range;
-    Type mask = std::numeric_limits<Type>::max ( );
-    mask >>= ext::detail::leading_zeros ( range | Type { 1 } );
-    Type x;
-    do {
-        x = rng ( ) & mask;
-    } while ( x > range );
-    return x;
+Type br_fixed ( Rng & rng, Type range ) NOEXCEPT {
+    return ext::algorithm::fixed<>::generate ( rng, range );
 }
 
 template<typename Rng, typename Type>
@@ -190,370 +195,489 @@ Type br_bitmask_alt ( Rng & rng, Type range_ ) NOEXCEPT {
 }
 
 
-template<typename Rng, typename Type>
-Type br_modx1 ( Rng & rng, Type range ) NOEXCEPT {
-    Type x, r;
-    do {
-        x = rng ( );
-        r = x % range;
-    } while ( x - r > Type ( 0 - range ) );
-    return r;
+using result_type = typename generator::result_type;
+
+inline constexpr int draws_per_iteration = 128;
+
+// Sets the counter cycles/draw, of the time stamp counter (at its constant rate) since start.
+void set_cycles ( benchmark::State & state, std::uint64_t start ) noexcept {
+    const std::uint64_t draws = static_cast<std::uint64_t> ( state.iterations ( ) ) * draws_per_iteration;
+    state.counters [ "cycles/draw" ] = draws ? static_cast<double> ( sf::cycles ( ) - start ) / draws : 0.0;
 }
 
-template<typename Rng, typename Type>
-Type br_modx1_bopt ( Rng & rng, Type range ) NOEXCEPT {
-    Type x, r;
-    if ( range >= Type { 1 } << ( std::numeric_limits<Type>::digits - 1 ) ) {
-        do {
-            r = rng ( );
-        } while ( r >= range );
-        return r;
+// Draws 128 numbers over [ 0, 2^state.range ( 0 ) ) per iteration, the range is opaque and the
+// memory is clobbered after every draw (the classic benchmark).
+template<result_type ( * Draw ) ( generator &, result_type )>
+void bm_bounded_rand ( benchmark::State & state ) NOEXCEPT {
+    static generator seeder ( 0xBE1C0467EBA5FAC );
+    result_type a = 0;
+    benchmark::DoNotOptimize ( &a );
+    generator gen ( seeder ( ) );
+    benchmark::DoNotOptimize ( &gen );
+    const std::uint64_t start = sf::cycles ( );
+    for ( auto _ : state ) {
+        const result_type range = result_type { 1 } << state.range ( 0 );
+        benchmark::DoNotOptimize ( &range );
+        for ( int i = 0; i < draws_per_iteration; ++i ) {
+            a += Draw ( gen, range );
+            benchmark::ClobberMemory ( );
+        }
     }
-    do {
-        x = rng ( );
-        r = x % range;
-    } while ( x - r > Type ( 0 - range ) );
-    return r;
+    set_cycles ( state, start );
 }
 
-template<typename Rng, typename Type>
-Type br_modx1_mopt ( Rng & rng, Type range ) NOEXCEPT {
-    Type x, r;
-    do {
-        x = rng ( );
-        r = x;
-        if ( r >= range ) {
-            r -= range;
-            if ( r >= range )
-                r %= range;
+// Throughput, independent draws (but for the engine state), the draws of an iteration overlap.
+template<result_type ( * Draw ) ( generator &, result_type )>
+void bm_throughput ( benchmark::State & state ) NOEXCEPT {
+    static generator seeder ( 0xBE1C0467EBA5FAC );
+    generator gen ( seeder ( ) );
+    result_type range = result_type { 1 } << state.range ( 0 ), out [ draws_per_iteration ];
+    benchmark::DoNotOptimize ( &range );
+    const std::uint64_t start = sf::cycles ( );
+    for ( auto _ : state ) {
+        for ( int i = 0; i < draws_per_iteration; ++i ) {
+            out [ i ] = Draw ( gen, range );
         }
-    } while ( x - r > Type ( 0 - range ) );
-    return r;
+        benchmark::DoNotOptimize ( out );
+    }
+    set_cycles ( state, start );
 }
 
-template<typename Rng, typename Type>
-Type br_debiased_modx2 ( Rng & rng, Type range ) NOEXCEPT {
-    Type t = ( 0 - range ) % range;
-    while ( true ) {
-        Type r = rng ( );
-        if ( r >= t ) {
-            return r % range;
+// Latency, the range of every draw depends on the previous draw (it is 2^shift or 2^shift - 1,
+// by its lowest bit), the draws form a chain.
+template<result_type ( * Draw ) ( generator &, result_type )>
+void bm_latency ( benchmark::State & state ) NOEXCEPT {
+    static generator seeder ( 0xBE1C0467EBA5FAC );
+    generator gen ( seeder ( ) );
+    result_type range = result_type { 1 } << state.range ( 0 ), x = 0;
+    benchmark::DoNotOptimize ( &range );
+    const std::uint64_t start = sf::cycles ( );
+    for ( auto _ : state ) {
+        for ( int i = 0; i < draws_per_iteration; ++i ) {
+            x = Draw ( gen, std::max ( range - ( x & 1 ), result_type { 1 } ) );
         }
     }
+    benchmark::DoNotOptimize ( x );
+    set_cycles ( state, start );
 }
 
-template<typename Rng, typename Type>
-Type br_modx2_topt ( Rng & rng, Type range ) NOEXCEPT {
-    Type r = rng ( );
-    if ( r < range ) {
-        Type t = ( 0 - range ) % range;
-        while ( r < t )
-            r = rng ( );
-    }
-    return r % range;
+// The range profiles of the mixed mode, tables of 2^12 ranges, drawn from realistic
+// distributions (seeded, the same for every algorithm), such that branch predictors can't
+// learn them.
+const char * const profile_names [ ] = { "small", "shuffle", "log_uniform", "large", "48_bit" };
+
+const std::vector<result_type> & profile ( int p ) {
+    static const std::vector<result_type> profiles [ ] = {
+        [ ] { // dice, cards and small containers, uniform in [ 1, 256 ].
+            generator gen ( 0x5EED'0001 );
+            std::vector<result_type> r ( 1 << 12 );
+            for ( result_type & x : r ) {
+                x = 1 + ( gen ( ) >> 56 );
+            }
+            return r;
+        } ( ),
+        [ ] { // the ranges of (partial) Fisher-Yates shuffles of random sizes, up to 2^20.
+            generator gen ( 0x5EED'0002 );
+            std::vector<result_type> r;
+            while ( r.size ( ) < ( 1 << 12 ) ) {
+                for ( result_type n = 1 + ( gen ( ) >> 44 ), k = 1 + ( gen ( ) >> 58 ); n and k and r.size ( ) < ( 1 << 12 ); --n, --k ) {
+                    r.push_back ( n );
+                }
+            }
+            return r;
+        } ( ),
+        [ ] { // log-uniform, every width in [ 1, 63 ] equally likely.
+            generator gen ( 0x5EED'0003 );
+            std::vector<result_type> r ( 1 << 12 );
+            for ( result_type & x : r ) {
+                const int width = 1 + static_cast<int> ( ( gen ( ) >> 32 ) * 63 >> 32 );
+                x = ( result_type { 1 } << ( width - 1 ) ) | ( ( gen ( ) >> 1 ) >> ( 64 - width ) );
+            }
+            return r;
+        } ( ),
+        [ ] { // large, uniform in [ 2^62, 2^63 ), up to half of the draws are rejected.
+            generator gen ( 0x5EED'0004 );
+            std::vector<result_type> r ( 1 << 12 );
+            for ( result_type & x : r ) {
+                x = ( result_type { 1 } << 62 ) | ( gen ( ) >> 2 );
+            }
+            return r;
+        } ( ),
+        [ ] { // 48-bit, uniform in [ 2^47, 2^48 ), a new 64-bit modulo per draw for a distribution.
+            generator gen ( 0x5EED'0005 );
+            std::vector<result_type> r ( 1 << 12 );
+            for ( result_type & x : r ) {
+                x = ( result_type { 1 } << 47 ) | ( gen ( ) >> 17 );
+            }
+            return r;
+        } ( )
+    };
+    return profiles [ p ];
 }
 
-template<typename Rng, typename Type>
-Type br_modx2_topt_bopt ( Rng & rng, Type range ) NOEXCEPT {
-    Type r = rng ( );
-    if ( range >= Type { 1 } << ( std::numeric_limits<Type>::digits - 1 ) ) {
-        while ( r >= range ) {
-            r = rng ( );
+// Mixed ranges, every draw over the next range of the profile state.range ( 0 ).
+template<result_type ( * Draw ) ( generator &, result_type )>
+void bm_mixed ( benchmark::State & state ) NOEXCEPT {
+    static generator seeder ( 0xBE1C0467EBA5FAC );
+    generator gen ( seeder ( ) );
+    const std::vector<result_type> & ranges = profile ( static_cast<int> ( state.range ( 0 ) ) );
+    const std::size_t mask = ranges.size ( ) - 1;
+    std::size_t j = 0;
+    result_type a = 0;
+    const std::uint64_t start = sf::cycles ( );
+    for ( auto _ : state ) {
+        for ( int i = 0; i < draws_per_iteration; ++i ) {
+            a += Draw ( gen, ranges [ j++ & mask ] );
         }
-        return r;
     }
-    if ( r < range ) {
-        uint64_t t = ( 0 - range ) % range;
-        while ( r < t ) {
-            r = rng ( );
+    benchmark::DoNotOptimize ( a );
+    set_cycles ( state, start );
+}
+
+struct algorithm {
+    std::string_view name;
+    void ( * classic ) ( benchmark::State & );
+    void ( * throughput ) ( benchmark::State & );
+    void ( * latency ) ( benchmark::State & );
+    void ( * mixed ) ( benchmark::State & );
+    bool standard; // benchmarked by default, the others with --all_algorithms.
+};
+
+#define BR_ALGORITHM( name, standard ) algorithm { #name, \
+    &bm_bounded_rand<&br_##name<generator, result_type>>, &bm_throughput<&br_##name<generator, result_type>>, \
+    &bm_latency<&br_##name<generator, result_type>>, &bm_mixed<&br_##name<generator, result_type>>, standard }
+
+const algorithm algorithms [ ] = {
+    BR_ALGORITHM ( stl, true ), BR_ALGORITHM ( fast, true ), BR_ALGORITHM ( bounded, true ),
+    BR_ALGORITHM ( lemire_oneill, true ), BR_ALGORITHM ( canon, true ), BR_ALGORITHM ( bitmask, true ),
+    BR_ALGORITHM ( lemire, false ), BR_ALGORITHM ( bitmask_alt, false ), BR_ALGORITHM ( fixed, false ),
+    BR_ALGORITHM ( debiased_div, false ), BR_ALGORITHM ( modx1, false ), BR_ALGORITHM ( modx1_bopt, false ),
+    BR_ALGORITHM ( modx1_mopt, false ), BR_ALGORITHM ( debiased_modx2, false ), BR_ALGORITHM ( modx2_topt, false ),
+    BR_ALGORITHM ( modx2_topt_bopt, false ), BR_ALGORITHM ( modx2_topt_mopt, false ), BR_ALGORITHM ( modx2_topt_moptx2, false )
+};
+
+#undef BR_ALGORITHM
+
+
+// The components of the library, the draws of which are not a bounded_rand function, each
+// draws 128 values (over [ 0, 2^shift ) if ranged, otherwise in the variant state.range ( 0 ))
+// per iteration, compare throughput/fast/<shift>.
+
+// buffered_uniform_int, the engine words are served from a 4KiB buffer.
+void bm_buffered ( benchmark::State & state ) NOEXCEPT {
+    static generator seeder ( 0xBE1C0467EBA5FAC );
+    generator gen ( seeder ( ) );
+    ext::buffered_uniform_int<result_type, generator> dis ( gen, 0, ( result_type { 1 } << state.range ( 0 ) ) - 1 );
+    result_type out [ draws_per_iteration ];
+    const std::uint64_t start = sf::cycles ( );
+    for ( auto _ : state ) {
+        for ( int i = 0; i < draws_per_iteration; ++i ) {
+            out [ i ] = dis ( );
         }
+        benchmark::DoNotOptimize ( out );
     }
-    return r % range;
+    set_cycles ( state, start );
 }
 
-template<typename Rng, typename Type>
-Type br_modx2_topt_mopt ( Rng & rng, Type range ) NOEXCEPT {
-    Type r = rng ( );
-    if ( r < range ) {
-        Type t = ( 0 - range );
-        if ( t >= range ) {
-            t -= range;
-            if ( t >= range ) {
-                t %= range;
-            }
-        }
-        while ( r < t ) {
-            r = rng ( );
+// uniform_int_producer, the values are produced on a helper thread (for the consumer, the cost
+// of the hand-over).
+void bm_producer ( benchmark::State & state ) NOEXCEPT {
+    static generator seeder ( 0xBE1C0467EBA5FAC );
+    ext::uniform_int_producer<result_type, generator> producer { generator ( seeder ( ) ), generator ( seeder ( ) ) };
+    const auto channel = producer.add ( 0, ( result_type { 1 } << state.range ( 0 ) ) - 1 );
+    producer.start ( );
+    result_type out [ draws_per_iteration ];
+    const std::uint64_t start = sf::cycles ( );
+    for ( auto _ : state ) {
+        for ( int i = 0; i < draws_per_iteration; ++i ) {
+            out [ i ] = producer ( channel );
         }
+        benchmark::DoNotOptimize ( out );
     }
-    return r % range;
+    set_cycles ( state, start );
+    state.counters [ "fallbacks" ] = static_cast<double> ( producer.fallbacks ( channel ) );
 }
 
-template<typename Rng, typename Type>
-Type br_modx2_topt_moptx2 ( Rng & rng, Type range ) NOEXCEPT {
-    Type r = rng ( );
-    if ( r < range ) {
-        Type t = ( 0 - range );
-        if ( t >= range ) {
-            t -= range;
-            if ( t >= range )
-                t %= range;
+// bounded_batch, 128 draws per call, over the same range in every lane.
+void bm_batch ( benchmark::State & state ) NOEXCEPT {
+    static generator seeder ( 0xBE1C0467EBA5FAC );
+    generator gen ( seeder ( ) );
+    result_type ranges [ draws_per_iteration ], out [ draws_per_iteration ];
+    std::fill_n ( ranges, draws_per_iteration, result_type { 1 } << state.range ( 0 ) );
+    const std::uint64_t start = sf::cycles ( );
+    for ( auto _ : state ) {
+        ext::bounded_batch ( gen, ranges, out, draws_per_iteration );
+        benchmark::DoNotOptimize ( out );
+    }
+    set_cycles ( state, start );
+}
+
+// uniform_index_distribution, a cell of a 1920 x 1080 or 256 x 256 x 256 grid (fused, a single
+// draw), or of a 2^40 x 2^40 grid (drawn per axis).
+void bm_index ( benchmark::State & state ) NOEXCEPT {
+    static generator seeder ( 0xBE1C0467EBA5FAC );
+    generator gen ( seeder ( ) );
+    const std::uint64_t e = std::uint64_t { 1 } << 40;
+    const ext::uniform_index_distribution<3> dis = 0 == state.range ( 0 ) ? ext::uniform_index_distribution<3> ( 1920, 1080, 1 )
+                                                 : 1 == state.range ( 0 ) ? ext::uniform_index_distribution<3> ( 256, 256, 256 )
+                                                 : ext::uniform_index_distribution<3> ( e, e, 1 );
+    std::size_t out [ draws_per_iteration ];
+    const std::uint64_t start = sf::cycles ( );
+    for ( auto _ : state ) {
+        for ( int i = 0; i < draws_per_iteration; ++i ) {
+            const auto cell = dis ( gen );
+            out [ i ] = cell [ 0 ] ^ cell [ 1 ] ^ cell [ 2 ];
         }
-        while ( r < t )
-            r = rng ( );
+        benchmark::DoNotOptimize ( out );
     }
-    if ( r >= range ) {
-        r -= range;
-        if ( r >= range )
-            r %= range;
+    set_cycles ( state, start );
+}
+
+// uniform_interval_distribution, over a set of 4 (the linear search) or 64 (the binary search)
+// intervals of 2^39 values.
+void bm_interval ( benchmark::State & state ) NOEXCEPT {
+    static generator seeder ( 0xBE1C0467EBA5FAC );
+    generator gen ( seeder ( ) );
+    std::vector<std::pair<result_type, result_type>> intervals;
+    for ( result_type i = 0, n = 0 == state.range ( 0 ) ? 4 : 64; i < n; ++i ) {
+        intervals.emplace_back ( i << 40, ( i << 40 ) + ( result_type { 1 } << 39 ) - 1 );
+    }
+    const ext::uniform_interval_distribution<result_type> dis ( intervals.begin ( ), intervals.end ( ) );
+    result_type out [ draws_per_iteration ];
+    const std::uint64_t start = sf::cycles ( );
+    for ( auto _ : state ) {
+        for ( int i = 0; i < draws_per_iteration; ++i ) {
+            out [ i ] = dis ( gen );
+        }
+        benchmark::DoNotOptimize ( out );
     }
-    return r;
+    set_cycles ( state, start );
 }
 
-template<typename Type>
-using unsigned_result_type = typename std::make_unsigned<Type>::type;
+// uniform_real_distribution_fast, 128 values in [ 0, 1 ), per call or by generate ( ).
+template<typename RealType, bool Dense>
+void real_draws ( benchmark::State & state, bool bulk ) NOEXCEPT {
+    static generator seeder ( 0xBE1C0467EBA5FAC );
+    generator gen ( seeder ( ) );
+    const ext::uniform_real_distribution_fast<RealType, Dense> dis;
+    RealType out [ draws_per_iteration ];
+    const std::uint64_t start = sf::cycles ( );
+    for ( auto _ : state ) {
+        if ( bulk ) {
+            dis.generate ( gen, out, out + draws_per_iteration );
+        }
+        else {
+            for ( int i = 0; i < draws_per_iteration; ++i ) {
+                out [ i ] = dis ( gen );
+            }
+        }
+        benchmark::DoNotOptimize ( out );
+    }
+    set_cycles ( state, start );
+}
 
-template<typename IT> struct double_width_integer { };
-template<> struct double_width_integer<std::uint8_t > { using type = std::uint16_t; };
-template<> struct double_width_integer<std::uint16_t> { using type = std::uint32_t; };
-template<> struct double_width_integer<std::uint32_t> { using type = std::uint64_t; };
-#if M32
-template<> struct double_width_integer<std::uint64_t> { using type = absl::uint128; };
-#endif
-#if M64 and GNU
-template<> struct double_width_integer<std::uint64_t> { using type = __uint128_t; };
-#endif
-#if M64 and MSVC
-template<> struct double_width_integer<std::uint64_t> { using type = std::uint64_t; };
-#endif
+void bm_real ( benchmark::State & state ) NOEXCEPT {
+    switch ( state.range ( 0 ) ) {
+        case 0: real_draws<float, false> ( state, false ); break;
+        case 1: real_draws<float, false> ( state, true ); break;
+        case 2: real_draws<double, false> ( state, false ); break;
+        case 3: real_draws<double, false> ( state, true ); break;
+        default: real_draws<double, true> ( state, false );
+    }
+}
 
+// bernoulli_fast, a coin (p = 1 / 2) and p = 3 / 8 (chunks of a cached word), p = 0.3 (a
+// threshold per word), and p = 0.3 by mask ( ), 64 draws per mask.
+void bm_bernoulli ( benchmark::State & state ) NOEXCEPT {
+    static generator seeder ( 0xBE1C0467EBA5FAC );
+    generator gen ( seeder ( ) );
+    ext::bernoulli_fast dis = 0 == state.range ( 0 ) ? ext::bernoulli_fast ( ) : 1 == state.range ( 0 ) ? ext::bernoulli_fast ( 3, 3 ) : ext::bernoulli_fast ( 0.3 );
+    std::uint64_t out [ draws_per_iteration ];
+    const std::uint64_t start = sf::cycles ( );
+    for ( auto _ : state ) {
+        if ( 3 == state.range ( 0 ) ) {
+            dis.generate ( gen, out, draws_per_iteration / 64 );
+        }
+        else {
+            for ( int i = 0; i < draws_per_iteration; ++i ) {
+                out [ i ] = dis ( gen );
+            }
+        }
+        benchmark::DoNotOptimize ( out );
+    }
+    set_cycles ( state, start );
+}
 
-template<typename Rng, typename Type, typename ResultType = Type>
-ResultType br_lemire ( Rng & rng, Type range ) NOEXCEPT {
-    #if MSVC and M64
-    if constexpr ( std::is_same<Type, std::uint64_t>::value ) {
-        const unsigned_result_type<ResultType> t = ( 0 - range ) % range;
-        unsigned_result_type<ResultType> x = rng ( );
-        unsigned_result_type<ResultType> h, l = _umul128 ( x, range, &h );
-        while ( l < t ) {
-            x = rng ( );
-            l = _umul128 ( x, range, &h );
-        };
-        return ResultType ( h );
+// fastrange, 128 hashes (the same every iteration) reduced onto [ 0, 1000003 ), 32- and 64-bit,
+// by the array, also by a prepared_range, of 1000003 and of 2^20.
+void bm_fastrange ( benchmark::State & state ) NOEXCEPT {
+    static generator seeder ( 0xBE1C0467EBA5FAC );
+    generator gen ( seeder ( ) );
+    std::uint32_t x32 [ draws_per_iteration ], out32 [ draws_per_iteration ];
+    std::uint64_t x64 [ draws_per_iteration ], out64 [ draws_per_iteration ];
+    for ( int i = 0; i < draws_per_iteration; ++i ) {
+        x64 [ i ] = gen ( );
+        x32 [ i ] = static_cast<std::uint32_t> ( x64 [ i ] >> 32 );
     }
-    else { // range is of type std::uint32_t.
-    #endif
-        using double_width_unsigned_result_type = typename double_width_integer<unsigned_result_type<ResultType>>::type;
-        const unsigned_result_type<ResultType> t = ( 0 - range ) % range;
-        unsigned_result_type<ResultType> x = rng ( );
-        double_width_unsigned_result_type m = double_width_unsigned_result_type ( x ) * double_width_unsigned_result_type ( range );
-        unsigned_result_type<ResultType> l = unsigned_result_type<ResultType> ( m );
-        while ( l < t ) {
-            x = rng ( );
-            m = double_width_unsigned_result_type ( x ) * double_width_unsigned_result_type ( range );
-            l = unsigned_result_type<ResultType> ( m );
-        };
-        return ResultType ( m >> std::numeric_limits<unsigned_result_type<ResultType>>::digits );
-    #if MSVC and M64
+    const ext::prepared_range<std::uint64_t> prepared ( 3 == state.range ( 0 ) ? 1u << 20 : 1'000'003u );
+    const std::uint64_t start = sf::cycles ( );
+    for ( auto _ : state ) {
+        benchmark::DoNotOptimize ( x32 );
+        benchmark::DoNotOptimize ( x64 );
+        if ( 0 == state.range ( 0 ) ) {
+            ext::fastrange ( x32, draws_per_iteration, 1'000'003u, out32 );
+            benchmark::DoNotOptimize ( out32 );
+        }
+        else {
+            if ( 1 == state.range ( 0 ) ) {
+                ext::fastrange ( x64, draws_per_iteration, 1'000'003u, out64 );
+            }
+            else {
+                prepared ( x64, draws_per_iteration, out64 );
+            }
+            benchmark::DoNotOptimize ( out64 );
+        }
     }
-    #endif
+    set_cycles ( state, start );
+}
+
+// random_string, 128 characters per call, over a hex (16), decimal (10), base62 and base64 alphabet.
+void bm_string ( benchmark::State & state ) NOEXCEPT {
+    static generator seeder ( 0xBE1C0467EBA5FAC );
+    static const char * const alphabets [ ] = { "0123456789abcdef", "0123456789",
+                                                "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz",
+                                                "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz+/" };
+    generator gen ( seeder ( ) );
+    const ext::random_string token ( alphabets [ state.range ( 0 ) ] );
+    char out [ draws_per_iteration ];
+    const std::uint64_t start = sf::cycles ( );
+    for ( auto _ : state ) {
+        token ( gen, out, draws_per_iteration );
+        benchmark::DoNotOptimize ( out );
+    }
+    set_cycles ( state, start );
 }
 
-template<typename Rng, typename Type, typename ResultType = Type>
-ResultType br_lemire_oneill ( Rng & rng, Type range ) NOEXCEPT {
-    #if MSVC and M64
-    if constexpr ( std::is_same<Type, std::uint64_t>::value ) {
-        unsigned_result_type<ResultType> x = rng ( );
-        if ( range >= ( unsigned_result_type<ResultType> { 1 } << ( sizeof ( unsigned_result_type<ResultType> ) * 8 - 1 ) ) ) {
-            do {
-                x = rng ( );
-            } while ( x >= range );
-            return ResultType ( x );
+// lookahead_index, 128 random probes into a table of 64MiB, the probe indices drawn directly
+// (direct) or 16 resp. 64 ahead of their use, their cache lines prefetched.
+void bm_lookahead ( benchmark::State & state ) NOEXCEPT {
+    static generator seeder ( 0xBE1C0467EBA5FAC );
+    static const std::vector<std::uint64_t> table ( std::size_t { 1 } << 23, 1 );
+    generator gen ( seeder ( ) );
+    const std::size_t n = table.size ( );
+    const ext::uniform_int_distribution_fast<std::size_t> dis ( 0, n - 1 );
+    ext::lookahead_index<generator> index ( gen, n, table.data ( ), sizeof ( std::uint64_t ), 1 == state.range ( 0 ) ? 16 : 64 );
+    std::uint64_t sum = 0;
+    const std::uint64_t start = sf::cycles ( );
+    for ( auto _ : state ) {
+        if ( 0 == state.range ( 0 ) ) {
+            for ( int i = 0; i < draws_per_iteration; ++i ) {
+                sum += table [ dis ( gen ) ];
+            }
         }
-        unsigned_result_type<ResultType> h, l = _umul128 ( x, range, &h );
-        if ( l < range ) {
-            unsigned_result_type<ResultType> t = ( 0 - range );
-            t -= range;
-            if ( t >= range ) {
-                t %= range;
+        else {
+            for ( int i = 0; i < draws_per_iteration; ++i ) {
+                sum += table [ index ( ) ];
             }
-            while ( l < t ) {
-                l = _umul128 ( rng ( ), range, &h );
+        }
+    }
+    benchmark::DoNotOptimize ( sum );
+    set_cycles ( state, start );
+}
+
+struct component {
+    std::string_view name;
+    void ( * function ) ( benchmark::State & );
+    std::vector<std::string_view> variants; // none, ranged, component/<name>/<shift>, else component/<name>/<variant>.
+};
+
+const component components [ ] = {
+    { "buffered", &bm_buffered, { } },
+    { "producer", &bm_producer, { } },
+    { "batch", &bm_batch, { } },
+    { "index", &bm_index, { "1920x1080", "256x256x256", "per_axis" } },
+    { "interval", &bm_interval, { "4_intervals", "64_intervals" } },
+    { "real", &bm_real, { "float", "float_generate", "double", "double_generate", "double_dense" } },
+    { "bernoulli", &bm_bernoulli, { "coin", "3_8", "0.3", "0.3_mask" } },
+    { "fastrange", &bm_fastrange, { "32", "64", "prepared_64", "prepared_64_pow2" } },
+    { "string", &bm_string, { "hex", "decimal", "base62", "base64" } },
+    { "lookahead", &bm_lookahead, { "direct", "distance_16", "distance_64" } }
+};
+
+
+// Registers the algorithm x range-width matrix, <mode>/<algorithm>/<shift>, ranges of 2^shift,
+// shift in [ 1, 63 ], and mixed/<algorithm>/<profile>, 4 repetitions each, of which the
+// aggregates (mean, median, stddev) are reported, with the counter cycles/draw. The modes
+// (--mode=classic,throughput,latency,mixed,components or all, classic by default) are
+// bounded_rand (the classic benchmark), throughput, latency, mixed and the components of the
+// library, component/<name>/<shift> or component/<name>/<variant>. Write JSON with --benchmark_out=file
+// --benchmark_out_format=json, that compare checks against a baseline.
+int main ( int argc, char ** argv ) {
+    bool all = false;
+    std::string_view modes = "classic";
+    int n = 1;
+    for ( int i = 1; i < argc; ++i ) {
+        const std::string_view arg = argv [ i ];
+        if ( arg == "--all_algorithms" ) {
+            all = true;
+        }
+        else if ( arg.substr ( 0, 7 ) == "--mode=" ) {
+            modes = arg.substr ( 7 );
+        }
+        else {
+            argv [ n++ ] = argv [ i ];
+        }
+    }
+    argc = n;
+    const auto selected = [ modes ] ( std::string_view mode ) {
+        return modes == "all" or ( "," + std::string ( modes ) + "," ).find ( "," + std::string ( mode ) + "," ) != std::string::npos;
+    };
+    const auto add = [ ] ( const std::string & name, void ( * function ) ( benchmark::State & ) ) {
+        return benchmark::RegisterBenchmark ( name.c_str ( ), function )->Repetitions ( 4 )->ReportAggregatesOnly ( true );
+    };
+    for ( int shift = 1; shift < 64; ++shift ) {
+        for ( const algorithm & a : algorithms ) {
+            if ( all or a.standard ) {
+                if ( selected ( "classic" ) ) {
+                    add ( "bounded_rand/" + std::string ( a.name ), a.classic )->Arg ( shift );
+                }
+                if ( selected ( "throughput" ) ) {
+                    add ( "throughput/" + std::string ( a.name ), a.throughput )->Arg ( shift );
+                }
+                if ( selected ( "latency" ) ) {
+                    add ( "latency/" + std::string ( a.name ), a.latency )->Arg ( shift );
+                }
             }
         }
-        return ResultType ( h );
     }
-    else { // range is of type std::uint32_t.
-    #endif
-        using double_width_unsigned_result_type = typename double_width_integer<unsigned_result_type<ResultType>>::type;
-        unsigned_result_type<ResultType> x = rng ( );
-        if ( range >= ( unsigned_result_type<ResultType> { 1 } << ( sizeof ( unsigned_result_type<ResultType> ) * 8 - 1 ) ) ) {
-            do {
-                x = rng ( );
-            } while ( x >= range );
-            return ResultType ( x );
+    if ( selected ( "mixed" ) ) {
+        for ( int p = 0; p < static_cast<int> ( std::size ( profile_names ) ); ++p ) {
+            profile ( p ); // generated outside of the measurements.
+            for ( const algorithm & a : algorithms ) {
+                if ( all or a.standard ) {
+                    add ( "mixed/" + std::string ( a.name ) + "/" + profile_names [ p ], a.mixed )->Arg ( p );
+                }
+            }
         }
-        double_width_unsigned_result_type m = double_width_unsigned_result_type ( x ) * double_width_unsigned_result_type ( range );
-        unsigned_result_type<ResultType> l = unsigned_result_type<ResultType> ( m );
-        if ( l < range ) {
-            unsigned_result_type<ResultType> t = ( 0 - range );
-            t -= range;
-            if ( t >= range ) {
-                t %= range;
+    }
+    if ( selected ( "components" ) ) {
+        for ( const component & c : components ) {
+            if ( c.variants.empty ( ) ) {
+                for ( int shift = 1; shift < 64; ++shift ) {
+                    add ( "component/" + std::string ( c.name ), c.function )->Arg ( shift );
+                }
             }
-            while ( l < t ) {
-                x = rng ( );
-                m = double_width_unsigned_result_type ( x ) * double_width_unsigned_result_type ( range );
-                l = unsigned_result_type<ResultType> ( m );
+            for ( int v = 0; v < static_cast<int> ( c.variants.size ( ) ); ++v ) {
+                add ( "component/" + std::string ( c.name ) + "/" + std::string ( c.variants [ v ] ), c.function )->Arg ( v );
             }
         }
-        return ResultType ( m >> std::numeric_limits<unsigned_result_type<ResultType>>::digits );
-    #if MSVC and M64
     }
-    #endif
+    benchmark::AddCustomContext ( "compiler", STR ( COMPILER ) );
+    benchmark::Initialize ( &argc, argv );
+    if ( benchmark::ReportUnrecognizedArguments ( argc, argv ) ) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks ( );
+    benchmark::Shutdown ( );
+    return 0;
 }
-
-
-#define BM_BR( func, name, shift ) \
-void func ( benchmark::State & state ) NOEXCEPT { \
-    static generator seeder ( 0xBE1C0467EBA5FAC ); \
-    using result_type = typename generator::result_type; \
-    result_type a = 0; \
-    benchmark::DoNotOptimize ( &a ); \
-    generator gen ( seeder ( ) ); \
-    benchmark::DoNotOptimize ( &gen ); \
-    for ( auto _ : state ) { \
-        const result_type range = result_type { 1 } << state.range ( 0 ); \
-        benchmark::DoNotOptimize ( &range ); \
-        for ( int i = 0; i < 128; ++i ) { \
-            a += br_##name ( gen, range ); \
-            benchmark::ClobberMemory ( ); \
-        } \
-    } \
-} \
-BENCHMARK ( func ) \
-->Repetitions ( 4 ) \
-->ReportAggregatesOnly ( true ) \
-->Arg ( shift );
-
-// benchmark::DoNotOptimize ( &a );
-// benchmark::ClobberMemory ( );
-
-#define CAT7( V1, V2, V3, V4, V5, V6, V7 ) V1 ## V2 ## V3 ## V4 ## V5 ## V6 ## V7
-#define FUNC( name, shift, compiler ) CAT7 ( bm_bounded_rand, _, name, _, shift, _, compiler )
-#define BM_BR_F( name, shift ) BM_BR ( FUNC ( name, shift, COMPILER ), name, shift )
-
-
-#define BM_BR_F_N( N ) \
-BM_BR_F ( stl, N ) \
-BM_BR_F ( fast, N ) \
-BM_BR_F ( lemire_oneill, N ) \
-BM_BR_F ( bitmask, N )
-
-// BM_BR_F ( lemire, N ) \
-// BM_BR_F ( bitmask_alt, N )
-
-/*
-\
-BM_BR_F ( modx1, N ) \
-BM_BR_F ( modx1_bopt, N ) \
-BM_BR_F ( modx1_mopt, N ) \
-BM_BR_F ( debiased_modx2, N ) \
-BM_BR_F ( modx2_topt, N ) \
-BM_BR_F ( modx2_topt_bopt, N ) \
-BM_BR_F ( modx2_topt_mopt, N ) \
-BM_BR_F ( modx2_topt_moptx2, N )
-*/
-
-#if 1
-BM_BR_F_N (  1 )
-BM_BR_F_N (  2 )
-BM_BR_F_N (  3 )
-BM_BR_F_N (  4 )
-BM_BR_F_N (  5 )
-BM_BR_F_N (  6 )
-BM_BR_F_N (  7 )
-BM_BR_F_N (  8 )
-BM_BR_F_N (  9 )
-BM_BR_F_N ( 10 )
-BM_BR_F_N ( 11 )
-BM_BR_F_N ( 12 )
-BM_BR_F_N ( 13 )
-BM_BR_F_N ( 14 )
-BM_BR_F_N ( 15 )
-BM_BR_F_N ( 16 )
-BM_BR_F_N ( 17 )
-BM_BR_F_N ( 18 )
-BM_BR_F_N ( 19 )
-BM_BR_F_N ( 20 )
-BM_BR_F_N ( 21 )
-BM_BR_F_N ( 22 )
-BM_BR_F_N ( 23 )
-BM_BR_F_N ( 24 )
-BM_BR_F_N ( 25 )
-BM_BR_F_N ( 26 )
-BM_BR_F_N ( 27 )
-BM_BR_F_N ( 28 )
-BM_BR_F_N ( 29 )
-BM_BR_F_N ( 30 )
-BM_BR_F_N ( 31 )
-
-BM_BR_F_N ( 32 )
-BM_BR_F_N ( 33 )
-BM_BR_F_N ( 34 )
-BM_BR_F_N ( 35 )
-BM_BR_F_N ( 36 )
-BM_BR_F_N ( 37 )
-BM_BR_F_N ( 38 )
-BM_BR_F_N ( 39 )
-BM_BR_F_N ( 40 )
-BM_BR_F_N ( 41 )
-BM_BR_F_N ( 42 )
-BM_BR_F_N ( 43 )
-BM_BR_F_N ( 44 )
-BM_BR_F_N ( 45 )
-BM_BR_F_N ( 46 )
-BM_BR_F_N ( 47 )
-BM_BR_F_N ( 48 )
-BM_BR_F_N ( 49 )
-BM_BR_F_N ( 50 )
-BM_BR_F_N ( 51 )
-BM_BR_F_N ( 52 )
-BM_BR_F_N ( 53 )
-BM_BR_F_N ( 54 )
-BM_BR_F_N ( 55 )
-BM_BR_F_N ( 56 )
-BM_BR_F_N ( 57 )
-BM_BR_F_N ( 58 )
-BM_BR_F_N ( 59 )
-BM_BR_F_N ( 60 )
-BM_BR_F_N ( 61 )
-BM_BR_F_N ( 62 )
-BM_BR_F_N ( 63 )
-
-#else
-BM_BR_F_N (  1 )
-BM_BR_F_N (  2 )
-BM_BR_F_N (  4 )
-BM_BR_F_N (  8 )
-BM_BR_F_N ( 16 )
-BM_BR_F_N ( 24 )
-BM_BR_F_N ( 25 )
-BM_BR_F_N ( 26 )
-BM_BR_F_N ( 27 )
-BM_BR_F_N ( 28 )
-BM_BR_F_N ( 29 )
-BM_BR_F_N ( 30 )
-BM_BR_F_N ( 31 )
-#if M64
-BM_BR_F_N ( 32 )
-BM_BR_F_N ( 48 )
-#if COMPILER == clang_x64
-BM_BR_F_N ( 59 )
-BM_BR_F_N ( 60 )
-BM_BR_F_N ( 61 )
-BM_BR_F_N ( 62 )
-#endif
-BM_BR_F_N ( 63 )
-#endif
-#endif
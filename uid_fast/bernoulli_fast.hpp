@@ -0,0 +1,177 @@
+
+// MIT License
+//
+// Copyright (c) 2018 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include <limits>
+
+#include "uniform_int_distribution_fast.hpp"
+
+#if _HAS_EXCEPTIONS == 0
+    #define NOEXCEPT
+#else
+    #define NOEXCEPT noexcept
+#endif
+
+
+namespace ext {
+
+// Bernoulli distribution, drawing a bool that is true with probability p. For p = k / 2^n,
+// n <= 16 (f.e. a coin flip, p = 1 / 2), an engine word is cached and n-bit chunks of it are
+// compared against k, one word serves 64 / n draws. Any other p is compared against a 64-bit
+// threshold, floor ( p * 2^64 ), per word. mask ( ) returns 64 draws as a packed bit-mask.
+class bernoulli_fast {
+
+    static constexpr int max_chunk_bits = 16;
+
+    template<typename Gen>
+    using generator_reference = detail::bits_engine<Gen, std::uint64_t, ( Gen::max ( ) < std::numeric_limits<std::uint64_t>::max ( ) )>;
+
+    public:
+
+    using result_type = bool;
+
+    explicit bernoulli_fast ( ) NOEXCEPT :
+        bernoulli_fast ( 1u, 1 ) { }
+    explicit bernoulli_fast ( double p_ ) NOEXCEPT :
+        p ( p_ ) {
+        assert ( p_ >= 0.0 and p_ <= 1.0 );
+        if ( p_ >= 1.0 ) {
+            always = true;
+            return;
+        }
+        threshold = static_cast<std::uint64_t> ( std::ldexp ( p_, 64 ) ); // exact, p < 1.
+        set_chunk ( );
+    }
+    // p = k / 2^n, exact, also where k / 2^n is not representable as a double (n > 53).
+    explicit bernoulli_fast ( std::uint64_t k_, int n_ ) NOEXCEPT :
+        p ( std::ldexp ( static_cast<double> ( k_ ), -n_ ) ) {
+        assert ( n_ >= 0 and n_ < 64 and k_ <= ( std::uint64_t { 1 } << n_ ) );
+        if ( k_ == ( std::uint64_t { 1 } << n_ ) ) {
+            always = true;
+            return;
+        }
+        threshold = n_ ? k_ << ( 64 - n_ ) : 0;
+        set_chunk ( );
+    }
+
+    // Drops the cached bits.
+    void reset ( ) NOEXCEPT {
+        bits = 0;
+    }
+
+    template<typename Gen>
+    [[ nodiscard ]] result_type operator ( ) ( Gen & rng ) NOEXCEPT {
+        if ( chunk_bits ) {
+            if ( bits < chunk_bits ) {
+                word = generator_reference<Gen> ( rng ) ( );
+                bits = 64;
+            }
+            const bool r = ( word & ( ( std::uint64_t { 1 } << chunk_bits ) - 1 ) ) < chunk_threshold;
+            word >>= chunk_bits;
+            bits -= chunk_bits;
+            return r;
+        }
+        if ( always ) {
+            return true;
+        }
+        return generator_reference<Gen> ( rng ) ( ) < threshold;
+    }
+
+    // Returns 64 draws, packed in a bit-mask. The 64 lanes compare their uniform 64-bit values
+    // with the threshold bit-sliced, from the top bit down, one engine word per bit, until all
+    // lanes are decided, on average some 8 words, at most one per significant bit of p.
+    template<typename Gen>
+    [[ nodiscard ]] std::uint64_t mask ( Gen & rng ) const NOEXCEPT {
+        if ( always ) {
+            return ~std::uint64_t { 0 };
+        }
+        generator_reference<Gen> rng_ref ( rng );
+        std::uint64_t undecided = ~std::uint64_t { 0 }, r = 0;
+        const int last = threshold ? trailing_zeros ( threshold ) : 64;
+        for ( int i = 63; i >= last and undecided; --i ) {
+            const std::uint64_t w = rng_ref ( );
+            if ( ( threshold >> i ) & 1u ) {
+                r |= undecided & ~w;
+                undecided &= w;
+            }
+            else {
+                undecided &= ~w;
+            }
+        }
+        return r;
+    }
+
+    // Fills [ first, first + n ) with packed 64-draw bit-masks.
+    template<typename Gen>
+    void generate ( Gen & rng, std::uint64_t * first, std::size_t n ) const NOEXCEPT {
+        while ( n-- ) {
+            *first++ = mask ( rng );
+        }
+    }
+
+    [[ nodiscard ]] double param ( ) const NOEXCEPT {
+        return p;
+    }
+
+    [[ nodiscard ]] static constexpr result_type min ( ) NOEXCEPT { return false; }
+    [[ nodiscard ]] static constexpr result_type max ( ) NOEXCEPT { return true; }
+
+    private:
+
+    // For a dyadic p, with a threshold of at most max_chunk_bits significant bits, uses the smallest chunk.
+    void set_chunk ( ) NOEXCEPT {
+        for ( int n = 1; n <= max_chunk_bits; ++n ) {
+            if ( not ( threshold & ( ( std::uint64_t { 1 } << ( 64 - n ) ) - 1 ) ) ) {
+                chunk_bits = n;
+                chunk_threshold = threshold >> ( 64 - n );
+                break;
+            }
+        }
+    }
+
+    [[ nodiscard ]] static int trailing_zeros ( std::uint64_t x ) NOEXCEPT {
+        int n = 0;
+        while ( not ( x & 1u ) ) {
+            x >>= 1;
+            ++n;
+        }
+        return n;
+    }
+
+    double p;
+    std::uint64_t threshold = 0, chunk_threshold = 0, word = 0;
+    int chunk_bits = 0, bits = 0;
+    bool always = false;
+};
+} // namespace ext
+
+
+// macro cleanup
+
+#undef NOEXCEPT
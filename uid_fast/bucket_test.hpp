@@ -0,0 +1,366 @@
+
+// MIT License
+//
+// Copyright (c) 2018 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "mapped_histogram.hpp"
+#include "splitmix.hpp"
+#include "statistics.hpp"
+#include "uniform_int_distribution_fast.hpp"
+
+
+// The Bucket-Test, draws from a distribution over [ 0, range ) are counted per value (bucket),
+// the spread of the counts tests the uniformity of the distribution, while making for a
+// meaningful workload for macro-benchmarking. The draws are cut in fixed-size chunks, each
+// with its own splitmix64 stream, split ( ) off a root stream in chunk order, the chunks are
+// handed out dynamically to the threads, which count into their own histogram shard. As the
+// chunks and their streams don't depend on the number of threads, neither do the counts.
+//
+// In the partitioned mode, for ranges beyond the caches, a thread draws blocks of values and
+// scatters them by their high bits into its own buffer per partition of the range. Only once a
+// buffer is full (and at the end) it is counted into the one shared histogram, under the lock
+// of that partition. The counters of a partition fit in L2, a flush increments as many values
+// into them as possible, within its span of buckets (and of pages), instead of spreading over all.
+namespace bt {
+
+using generator = splitmix64;
+using counter_type = std::uint64_t;
+
+struct options {
+    std::uint64_t range = 200'000, draws = std::uint64_t { 1 } << 31, chunk = std::uint64_t { 1 } << 22, seed = 123;
+    unsigned threads = std::max ( std::thread::hardware_concurrency ( ), 1u );
+    std::string_view distribution = "fast";
+    bool partitioned = false;
+    unsigned cell_bits = 64; // 8 or 16 bits count into a mapped_histogram (partitioned).
+    std::string_view histogram_file; // the file backing the mapped_histogram, if any.
+};
+
+// A partitioned block of draws, partitions span at least 2^partition_span_bits buckets (256KiB
+// of counters), there are at most 2^partition_fanout_bits of them. The buffers of a thread hold
+// 2^partition_buffer_bits values (16MiB) in all, at least partition_buffer_min per partition.
+inline constexpr std::size_t partition_block = std::size_t { 1 } << 16;
+inline constexpr int partition_span_bits = 15, partition_fanout_bits = 12, partition_buffer_bits = 21;
+inline constexpr std::size_t partition_buffer_min = 256;
+
+struct kernel_type {
+    // Counts draws draws over [ 0, range ) from rng into counts.
+    void ( * count ) ( generator & rng, std::uint64_t range, std::uint64_t draws, counter_type * counts );
+    // Writes draws draws over [ 0, range ) from rng to values.
+    void ( * fill ) ( generator & rng, std::uint64_t range, std::uint64_t draws, std::uint64_t * values );
+    // Records the cycles of every one of draws draws over [ 0, range ) from rng into latencies.
+    void ( * latency ) ( generator & rng, std::uint64_t range, std::uint64_t draws, sf::latency_histogram<> & latencies );
+};
+
+template<typename Distribution>
+void count ( generator & rng, std::uint64_t range, std::uint64_t draws, counter_type * counts ) {
+    Distribution dis ( 0, static_cast<typename Distribution::result_type> ( range - 1 ) );
+    while ( draws-- ) {
+        ++counts [ static_cast<std::size_t> ( dis ( rng ) ) ];
+    }
+}
+
+template<typename Distribution>
+void fill ( generator & rng, std::uint64_t range, std::uint64_t draws, std::uint64_t * values ) {
+    Distribution dis ( 0, static_cast<typename Distribution::result_type> ( range - 1 ) );
+    while ( draws-- ) {
+        *values++ = dis ( rng );
+    }
+}
+
+template<typename Distribution>
+void latency ( generator & rng, std::uint64_t range, std::uint64_t draws, sf::latency_histogram<> & latencies ) {
+    Distribution dis ( 0, static_cast<typename Distribution::result_type> ( range - 1 ) );
+    std::uint64_t sink = 0;
+    while ( draws-- ) {
+        sink += latencies.time ( [ & ] ( ) { return dis ( rng ); } );
+    }
+    volatile std::uint64_t keep = sink;
+    ( void ) keep;
+}
+
+template<typename IntType>
+void count_bounded ( generator & rng, std::uint64_t range, std::uint64_t draws, counter_type * counts ) {
+    while ( draws-- ) {
+        ++counts [ static_cast<std::size_t> ( ext::bounded ( rng, static_cast<IntType> ( range ) ) ) ];
+    }
+}
+
+template<typename IntType>
+void fill_bounded ( generator & rng, std::uint64_t range, std::uint64_t draws, std::uint64_t * values ) {
+    while ( draws-- ) {
+        *values++ = ext::bounded ( rng, static_cast<IntType> ( range ) );
+    }
+}
+
+template<typename IntType>
+void latency_bounded ( generator & rng, std::uint64_t range, std::uint64_t draws, sf::latency_histogram<> & latencies ) {
+    std::uint64_t sink = 0;
+    while ( draws-- ) {
+        sink += latencies.time ( [ & ] ( ) { return ext::bounded ( rng, static_cast<IntType> ( range ) ); } );
+    }
+    volatile std::uint64_t keep = sink;
+    ( void ) keep;
+}
+
+template<typename Distribution>
+inline constexpr kernel_type kernel_of { &count<Distribution>, &fill<Distribution>, &latency<Distribution> };
+
+// The kernels of the distributions over IntType, std, fast, bounded and all algorithm policies
+// of uniform_int_distribution_fast, by name.
+template<typename IntType>
+[[ nodiscard ]] const auto & kernel_table ( ) noexcept {
+    using namespace ext::algorithm;
+    #define BT_POLICY( policy ) std::pair<std::string_view, kernel_type> { #policy, kernel_of<ext::uniform_int_distribution_fast<IntType, policy>> }
+    static const std::array kernels = {
+        std::pair<std::string_view, kernel_type> { "std", kernel_of<std::uniform_int_distribution<IntType>> },
+        std::pair<std::string_view, kernel_type> { "fast", kernel_of<ext::uniform_int_distribution_fast<IntType>> },
+        std::pair<std::string_view, kernel_type> { "bounded", { &count_bounded<IntType>, &fill_bounded<IntType>, &latency_bounded<IntType> } },
+        BT_POLICY ( lemire ), BT_POLICY ( lemire_oneill ), BT_POLICY ( canon ), BT_POLICY ( bitmask ),
+        BT_POLICY ( debiased_div ), BT_POLICY ( modx1 ), BT_POLICY ( modx1_bopt ), BT_POLICY ( modx1_mopt ),
+        BT_POLICY ( debiased_modx2 ), BT_POLICY ( modx2_topt ), BT_POLICY ( modx2_topt_bopt ),
+        BT_POLICY ( modx2_topt_mopt ), BT_POLICY ( modx2_topt_moptx2 ), BT_POLICY ( fixed<> ), BT_POLICY ( automatic )
+    };
+    #undef BT_POLICY
+    return kernels;
+}
+
+// Returns the kernel of the distribution called name over width-bit (16, 32 or 64) integers
+// (null functions if unknown).
+[[ nodiscard ]] inline kernel_type find_kernel ( std::string_view name, int width = 64 ) {
+    const auto find = [ name ] ( const auto & kernels ) -> kernel_type {
+        for ( const auto & [ n, k ] : kernels ) {
+            if ( n == name ) {
+                return k;
+            }
+        }
+        return { nullptr, nullptr, nullptr };
+    };
+    switch ( width ) {
+        case 16: return find ( kernel_table<std::uint16_t> ( ) );
+        case 32: return find ( kernel_table<std::uint32_t> ( ) );
+        case 64: return find ( kernel_table<std::uint64_t> ( ) );
+        default: return { nullptr, nullptr, nullptr };
+    }
+}
+
+// A histogram shard, the counts start on (and are padded to) a cache line, such that no two
+// shards share one.
+class shard {
+
+    static constexpr std::size_t line = 64 / sizeof ( counter_type );
+
+    public:
+
+    explicit shard ( std::size_t size_ ) :
+        storage ( size_ + 2 * line, 0 ),
+        size ( size_ ) {
+        offset = ( line - ( reinterpret_cast<std::uintptr_t> ( storage.data ( ) ) / sizeof ( counter_type ) ) % line ) % line;
+    }
+
+    [[ nodiscard ]] counter_type * data ( ) noexcept {
+        return storage.data ( ) + offset;
+    }
+    [[ nodiscard ]] const counter_type * data ( ) const noexcept {
+        return storage.data ( ) + offset;
+    }
+
+    [[ nodiscard ]] counter_type * begin ( ) noexcept {
+        return data ( );
+    }
+    [[ nodiscard ]] counter_type * end ( ) noexcept {
+        return data ( ) + size;
+    }
+
+    private:
+
+    std::vector<counter_type> storage;
+    std::size_t size, offset;
+};
+
+// Runs f ( t ) on threads t = 0, 1, ..., n - 1 and joins them.
+template<typename F>
+void parallel ( unsigned n, F && f ) {
+    std::vector<std::thread> threads;
+    threads.reserve ( n );
+    for ( unsigned t = 0; t < n; ++t ) {
+        threads.emplace_back ( f, t );
+    }
+    for ( std::thread & t : threads ) {
+        t.join ( );
+    }
+}
+
+// Adds the shards pairwise, in log2 ( shards ) rounds, every round is spread over all threads
+// by slices of the buckets, shard 0 holds the sums.
+inline void reduce ( std::vector<shard> & shards, std::uint64_t range, unsigned threads ) {
+    for ( std::size_t stride = 1; stride < shards.size ( ); stride *= 2 ) {
+        parallel ( threads, [ & ] ( unsigned t ) {
+            const std::size_t first = range * t / threads, last = range * ( t + 1 ) / threads;
+            for ( std::size_t i = 0; i + stride < shards.size ( ); i += 2 * stride ) {
+                counter_type * const a = shards [ i ].data ( );
+                const counter_type * const b = shards [ i + stride ].data ( );
+                for ( std::size_t j = first; j < last; ++j ) {
+                    a [ j ] += b [ j ];
+                }
+            }
+        } );
+    }
+}
+
+// Returns the shift of a bucket to its partition.
+[[ nodiscard ]] inline int partition_shift ( std::uint64_t range ) noexcept {
+    int bits = 0; // ceil ( log2 ( range ) ).
+    while ( bits < 64 and ( std::uint64_t { 1 } << bits ) < range ) {
+        ++bits;
+    }
+    return std::max ( partition_span_bits, bits - partition_fanout_bits );
+}
+
+// Counts the chunks, partitioned, by increment ( bucket ).
+template<typename Increment>
+void count_partitioned ( const options & o, kernel_type kernel, std::vector<generator> & streams, unsigned threads, Increment increment ) {
+    const std::uint64_t chunks = streams.size ( );
+    const int shift = partition_shift ( o.range );
+    const std::size_t partitions = static_cast<std::size_t> ( ( o.range - 1 ) >> shift ) + 1;
+    const std::size_t capacity = std::max ( partition_buffer_min, ( std::size_t { 1 } << partition_buffer_bits ) / partitions );
+    std::vector<std::mutex> locks ( partitions );
+    std::atomic<std::uint64_t> next { 0 };
+    parallel ( threads, [ & ] ( unsigned t ) {
+        std::vector<std::uint64_t> values ( partition_block ), buffers ( partitions * capacity );
+        std::vector<std::size_t> sizes ( partitions, 0 );
+        const auto flush = [ & ] ( std::size_t p ) {
+            const std::uint64_t * const buffer = buffers.data ( ) + p * capacity;
+            std::lock_guard<std::mutex> lock ( locks [ p ] );
+            for ( std::size_t i = 0; i < sizes [ p ]; ++i ) {
+                increment ( static_cast<std::size_t> ( buffer [ i ] ) );
+            }
+            sizes [ p ] = 0;
+        };
+        for ( std::uint64_t c; ( c = next.fetch_add ( 1, std::memory_order_relaxed ) ) < chunks; ) {
+            for ( std::uint64_t left = std::min ( o.chunk, o.draws - c * o.chunk ); left; ) {
+                const std::size_t n = static_cast<std::size_t> ( std::min<std::uint64_t> ( left, partition_block ) );
+                left -= n;
+                kernel.fill ( streams [ c ], o.range, n, values.data ( ) );
+                for ( std::size_t i = 0; i < n; ++i ) {
+                    const std::size_t p = static_cast<std::size_t> ( values [ i ] >> shift );
+                    buffers [ p * capacity + sizes [ p ]++ ] = values [ i ];
+                    if ( sizes [ p ] == capacity ) {
+                        flush ( p );
+                    }
+                }
+            }
+        }
+        // The threads start at different partitions, such as not to queue up on the locks.
+        const std::size_t origin = partitions * t / threads;
+        for ( std::size_t j = 0; j < partitions; ++j ) {
+            flush ( ( j + origin ) % partitions );
+        }
+    } );
+}
+
+// Returns the streams of the chunks.
+[[ nodiscard ]] inline std::vector<generator> split ( const options & o ) {
+    const std::uint64_t chunks = ( o.draws + o.chunk - 1 ) / o.chunk;
+    std::vector<generator> streams;
+    streams.reserve ( chunks );
+    generator root ( o.seed );
+    for ( std::uint64_t c = 0; c < chunks; ++c ) {
+        streams.push_back ( root.split ( ) );
+    }
+    return streams;
+}
+
+[[ nodiscard ]] inline unsigned thread_count ( const options & o, std::uint64_t chunks ) noexcept {
+    return static_cast<unsigned> ( std::max ( std::min<std::uint64_t> ( o.threads, chunks ), std::uint64_t { 1 } ) );
+}
+
+// Runs the bucket test, returns the counts of the buckets.
+[[ nodiscard ]] inline std::vector<counter_type> run ( const options & o, kernel_type kernel ) {
+    std::vector<generator> streams = split ( o );
+    const std::uint64_t chunks = streams.size ( );
+    const unsigned threads = thread_count ( o, chunks );
+    if ( o.partitioned ) {
+        shard counts ( o.range );
+        counter_type * const data = counts.data ( );
+        count_partitioned ( o, kernel, streams, threads, [ data ] ( std::size_t i ) { ++data [ i ]; } );
+        return { counts.begin ( ), counts.end ( ) };
+    }
+    std::vector<shard> shards;
+    shards.reserve ( threads );
+    for ( unsigned t = 0; t < threads; ++t ) {
+        shards.emplace_back ( o.range );
+    }
+    std::atomic<std::uint64_t> next { 0 };
+    parallel ( threads, [ & ] ( unsigned t ) {
+        for ( std::uint64_t c; ( c = next.fetch_add ( 1, std::memory_order_relaxed ) ) < chunks; ) {
+            kernel.count ( streams [ c ], o.range, std::min ( o.chunk, o.draws - c * o.chunk ), shards [ t ].data ( ) );
+        }
+    } );
+    reduce ( shards, o.range, threads );
+    return { shards [ 0 ].begin ( ), shards [ 0 ].end ( ) };
+}
+
+// Runs the bucket test, partitioned, into a mapped_histogram of Cell-wide cells, a partition is
+// counted by one thread at a time, and spans whole pages of carries.
+template<typename Cell>
+[[ nodiscard ]] mapped_histogram<Cell, counter_type> run_mapped ( const options & o, kernel_type kernel ) {
+    static_assert ( partition_span_bits >= mapped_histogram<Cell, counter_type>::page_bits, "the partitions should span whole pages of carries." );
+    std::vector<generator> streams = split ( o );
+    mapped_histogram<Cell, counter_type> counts ( static_cast<std::size_t> ( o.range ), std::string ( o.histogram_file ) );
+    count_partitioned ( o, kernel, streams, thread_count ( o, streams.size ( ) ), [ & counts ] ( std::size_t i ) { counts.increment ( i ); } );
+    return counts;
+}
+
+// Runs the bucket test, recording the latency of every draw (in cycles) rather than counting.
+[[ nodiscard ]] inline sf::latency_histogram<> run_latency ( const options & o, kernel_type kernel ) {
+    std::vector<generator> streams = split ( o );
+    const std::uint64_t chunks = streams.size ( );
+    const unsigned threads = thread_count ( o, chunks );
+    std::vector<sf::latency_histogram<>> latencies ( threads );
+    std::atomic<std::uint64_t> next { 0 };
+    parallel ( threads, [ & ] ( unsigned t ) {
+        for ( std::uint64_t c; ( c = next.fetch_add ( 1, std::memory_order_relaxed ) ) < chunks; ) {
+            kernel.latency ( streams [ c ], o.range, std::min ( o.chunk, o.draws - c * o.chunk ), latencies [ t ] );
+        }
+    } );
+    for ( unsigned t = 1; t < threads; ++t ) {
+        latencies [ 0 ].merge ( latencies [ t ] );
+    }
+    return std::move ( latencies [ 0 ] );
+}
+} // namespace bt
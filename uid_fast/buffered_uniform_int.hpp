@@ -0,0 +1,170 @@
+
+// MIT License
+//
+// Copyright (c) 2018 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <array>
+
+#include "uniform_int_distribution_fast.hpp"
+
+#if defined ( _WIN32 ) && ! ( defined ( __clang__ ) || defined ( __GNUC__ ) ) // MSVC and not clang or gcc on windows.
+    #define GNU 0
+    #define MSVC 1
+#else
+    #define GNU 1
+    #define MSVC 0
+#endif
+
+#if _HAS_EXCEPTIONS == 0
+    #define NOEXCEPT
+#else
+    #define NOEXCEPT noexcept
+#endif
+
+#if GNU
+    #define COLD __attribute__ ( ( noinline, cold ) )
+    #define UNLIKELY( x ) __builtin_expect ( !!( x ), 0 )
+#else
+    #define COLD __declspec ( noinline )
+    #define UNLIKELY( x ) ( x )
+#endif
+
+
+namespace ext {
+
+// A URBG, serving the output of Gen from a cache-line aligned buffer of (by default) 4KiB,
+// sized to fit comfortably in L1. The buffer is refilled in bulk (through Gen::generate, if
+// available) on a cold, out-of-line path, the fast path is a load and a bump of the index.
+template<typename Gen, std::size_t BufferBytes = 4'096>
+class buffered_engine {
+
+    public:
+
+    using generator_type = Gen;
+    using result_type = typename Gen::result_type;
+
+    static constexpr std::size_t buffer_size = BufferBytes / sizeof ( result_type );
+
+    static_assert ( buffer_size > 0, "the buffer should at least hold one result_type." );
+
+    [[ nodiscard ]] static constexpr result_type min ( ) NOEXCEPT { return Gen::min ( ); }
+    [[ nodiscard ]] static constexpr result_type max ( ) NOEXCEPT { return Gen::max ( ); }
+
+    explicit buffered_engine ( Gen & gen_ ) NOEXCEPT :
+        index ( buffer_size ), // empty, the first call refills.
+        gen ( gen_ ) {
+    }
+
+    [[ nodiscard ]] result_type operator ( ) ( ) NOEXCEPT {
+        if ( UNLIKELY ( buffer_size == index ) ) {
+            refill ( );
+        }
+        return buffer [ index++ ];
+    }
+
+    // Drops the buffered words, f.e. after (re-)seeding the underlying engine.
+    void flush ( ) NOEXCEPT {
+        index = buffer_size;
+    }
+
+    [[ nodiscard ]] Gen & generator ( ) const NOEXCEPT {
+        return gen;
+    }
+
+    private:
+
+    COLD void refill ( ) NOEXCEPT {
+        detail::generate ( gen, buffer.begin ( ), buffer.end ( ) );
+        index = 0;
+    }
+
+    alignas ( 64 ) std::array<result_type, buffer_size> buffer;
+    std::size_t index;
+    Gen & gen;
+};
+
+
+// Adapter, combining a uniform_int_distribution_fast with a buffered_engine, drawing from
+// the pre-generated words with a tiny inlined fast path.
+template<typename IntType, typename Gen, std::size_t BufferBytes = 4'096>
+class buffered_uniform_int {
+
+    public:
+
+    using result_type = IntType;
+    using distribution_type = uniform_int_distribution_fast<result_type>;
+    using param_type = typename distribution_type::param_type;
+    using engine_type = buffered_engine<Gen, BufferBytes>;
+
+    explicit buffered_uniform_int ( Gen & gen_ ) NOEXCEPT :
+        engine ( gen_ ),
+        distribution ( ) { }
+    explicit buffered_uniform_int ( Gen & gen_, result_type a, result_type b = std::numeric_limits<result_type>::max ( ) ) NOEXCEPT :
+        engine ( gen_ ),
+        distribution ( a, b ) { }
+    explicit buffered_uniform_int ( Gen & gen_, const param_type & params_ ) NOEXCEPT :
+        engine ( gen_ ),
+        distribution ( params_ ) { }
+
+    [[ nodiscard ]] result_type operator ( ) ( ) NOEXCEPT {
+        return distribution ( engine );
+    }
+
+    [[ nodiscard ]] result_type operator ( ) ( const param_type & params_ ) NOEXCEPT {
+        return distribution_type ( params_ ) ( engine );
+    }
+
+    [[ nodiscard ]] param_type param ( ) const NOEXCEPT {
+        return distribution.param ( );
+    }
+
+    void param ( const param_type & params_ ) NOEXCEPT {
+        distribution.param ( params_ );
+    }
+
+    void reset ( ) NOEXCEPT {
+        engine.flush ( );
+    }
+
+    [[ nodiscard ]] Gen & generator ( ) const NOEXCEPT {
+        return engine.generator ( );
+    }
+
+    private:
+
+    engine_type engine;
+    distribution_type distribution;
+};
+} // namespace ext
+
+
+// macro cleanup
+
+#undef UNLIKELY
+#undef COLD
+#undef GNU
+#undef MSVC
+#undef NOEXCEPT
@@ -1 +1 @@
-g++ -o g86.exe main.cpp -O3 -std=c++17 -m32 -march=broadwell -mtune=broadwell -labsl_int128 -labsl_numeric
+g++ -o g86.exe main.cpp -O3 -std=c++17 -m32 -march=broadwell -mtune=broadwell -pthread
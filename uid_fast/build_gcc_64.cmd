@@ -1 +1 @@
-g++ -o g64.exe main.cpp -O3 -std=c++17 -m64 -march=broadwell -mtune=broadwell -labsl_int128 -labsl_numeric
+g++ -o g64.exe main.cpp -O3 -std=c++17 -m64 -march=broadwell -mtune=broadwell -pthread
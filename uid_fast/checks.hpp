@@ -0,0 +1,989 @@
+
+// MIT License
+//
+// Copyright (c) 2018 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <bitset>
+#include <cmath>
+#include <chrono>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <string_view>
+#include <vector>
+
+#if __has_include ( <unistd.h> )
+    #include <unistd.h>
+#endif
+
+#include "bernoulli_fast.hpp"
+#include "bucket_test.hpp"
+#include "lookahead_index.hpp"
+#include "fastrange.hpp"
+#include "buffered_uniform_int.hpp"
+#include "random_string.hpp"
+#include "splitmix.hpp"
+#include "statistics.hpp"
+#include "uniform_int_batch.hpp"
+#include "uniform_int_distribution_fast.hpp"
+#include "uniform_index_distribution.hpp"
+#include "uniform_int_producer.hpp"
+#include "uniform_interval_distribution.hpp"
+#include "uniform_real_distribution_fast.hpp"
+#include "uniformity_suite.hpp"
+
+
+// The checks of the components of the library (uid_fast --check), every component draws over
+// some ranges through a fill function (as the kernels of the bucket test), the values are
+// checked to be within the range and are run through the uniformity test suite. Where a
+// component should reproduce a known sequence (f.e. that of uniform_int_distribution_fast),
+// or has properties that can be checked exactly, these are checked as well.
+namespace ck {
+
+using bt::generator;
+using fill_type = void ( * ) ( generator & rng, std::uint64_t range, std::uint64_t draws, std::uint64_t * values );
+
+inline constexpr std::uint64_t check_draws = std::uint64_t { 1 } << 20;
+
+// Returns true if all draws of fill are in [ 0, range ).
+[[ nodiscard ]] inline bool in_range ( fill_type fill, std::uint64_t range ) {
+    generator rng ( 0x5EED );
+    std::vector<std::uint64_t> values ( bt::partition_block );
+    fill ( rng, range, values.size ( ), values.data ( ) );
+    return std::all_of ( values.begin ( ), values.end ( ), [ range ] ( std::uint64_t v ) { return v < range; } );
+}
+
+// Reports whether the property holds, returns 1 if it doesn't.
+inline int expect ( std::ostream & out, std::string_view name, std::string_view property, bool holds ) {
+    out.width ( 17 ), out << std::left << name << std::right << property << ( holds ? "  ok\n" : "  FAILED\n" );
+    return not holds;
+}
+
+// Checks the draws of fill over the ranges (of width-bit values), returns the number of
+// failures, ranges out of range or suspect.
+inline int check ( std::ostream & out, std::string_view name, fill_type fill, int width, const std::vector<std::uint64_t> & ranges ) {
+    bt::options o;
+    o.draws = check_draws;
+    o.chunk = bt::partition_block;
+    int failures = 0;
+    for ( const std::uint64_t range : ranges ) {
+        if ( not in_range ( fill, range ) ) {
+            out.width ( 17 ), out << std::left << name << std::right << "out of range [ 0, " << range << " )  FAILED\n";
+            ++failures;
+            continue;
+        }
+        bt::suite_result r = bt::test ( o, { nullptr, fill, nullptr }, width, range );
+        r.distribution = name;
+        bt::report ( out, r );
+        failures += r.min_p ( ) < bt::suite_alpha;
+    }
+    return failures;
+}
+
+
+// buffered_uniform_int, the draws are those of uniform_int_distribution_fast, with or without
+// the buffer, also after a flush ( ).
+inline void fill_buffered ( generator & rng, std::uint64_t range, std::uint64_t draws, std::uint64_t * values ) {
+    ext::buffered_uniform_int<std::uint64_t, generator> dis ( rng, 0, range - 1 );
+    while ( draws-- ) {
+        *values++ = dis ( );
+    }
+}
+
+inline int check_buffered ( std::ostream & out ) {
+    int failures = check ( out, "buffered", &fill_buffered, 64, bt::suite_ranges ( 64 ) );
+    generator gen ( 1 ), reference_gen ( 1 );
+    ext::buffered_uniform_int<std::uint64_t, generator> buffered ( gen, 0, 999 );
+    ext::uniform_int_distribution_fast<std::uint64_t> reference ( 0, 999 );
+    bool equal = true;
+    for ( int i = 0; i < 10'000; ++i ) {
+        equal = equal and buffered ( ) == reference ( reference_gen );
+    }
+    failures += expect ( out, "buffered", "the sequence of uniform_int_distribution_fast", equal );
+    buffered.reset ( ); // flushes the buffer, the draws continue from the engine.
+    reference_gen = gen;
+    for ( int i = 0; i < 10'000; ++i ) {
+        equal = equal and buffered ( ) == reference ( reference_gen );
+    }
+    return failures + expect ( out, "buffered", "the sequence of uniform_int_distribution_fast after a flush", equal );
+}
+
+
+// uniform_int_producer, every value is taken from a block or generated inline (a fallback),
+// the helper thread sleeps once the rings are full.
+inline void fill_producer ( generator & rng, std::uint64_t range, std::uint64_t draws, std::uint64_t * values ) {
+    ext::uniform_int_producer<std::uint64_t, generator> producer ( rng.split ( ), rng.split ( ) );
+    const auto channel = producer.add ( 0, range - 1 );
+    producer.start ( );
+    while ( draws-- ) {
+        *values++ = producer ( channel );
+    }
+}
+
+inline int check_producer ( std::ostream & out ) {
+    int failures = check ( out, "producer", &fill_producer, 64, bt::suite_ranges ( 64 ) );
+    ext::uniform_int_producer<std::uint64_t, generator> producer ( generator ( 1 ), generator ( 2 ) );
+    const auto dice = producer.add ( 1, 6 ), cards = producer.add ( 0, 51 );
+    producer.start ( );
+    bool in_range = true;
+    for ( int i = 0; i < 1'000'000; ++i ) {
+        const std::uint64_t d = producer ( dice ), c = producer ( cards );
+        in_range = in_range and d >= 1 and d <= 6 and c < 52;
+    }
+    failures += expect ( out, "producer", "two channels in range", in_range );
+    const bool accounted = producer.blocks ( dice ) * 512 + producer.fallbacks ( dice ) >= 1'000'000 and producer.blocks ( dice ) * 512 < 1'000'000 + 512;
+    failures += expect ( out, "producer", "every value from a block or a fallback", accounted );
+    // The rings fill up (within 10s, however loaded the machine), then the helper thread makes
+    // no more rounds.
+    for ( int i = 0; i < 1'000 and not producer.asleep ( ); ++i ) {
+        std::this_thread::sleep_for ( std::chrono::milliseconds ( 10 ) );
+    }
+    const std::uint64_t rounds = producer.rounds ( );
+    std::this_thread::sleep_for ( std::chrono::milliseconds ( 50 ) );
+    return failures + expect ( out, "producer", "sleeps with the rings full", producer.asleep ( ) and rounds == producer.rounds ( ) );
+}
+
+
+// bounded_batch, over a single range, as well as over ranges that change from lane to lane
+// (those of a shuffle, also of 16- and 32-bit values).
+inline void fill_batch ( generator & rng, std::uint64_t range, std::uint64_t draws, std::uint64_t * values ) {
+    const std::vector<std::uint64_t> ranges ( draws, range );
+    ext::bounded_batch ( rng, ranges.data ( ), values, draws );
+}
+
+template<typename UIntType>
+[[ nodiscard ]] bool batch_in_ranges ( std::uint64_t seed ) {
+    generator rng ( seed );
+    std::vector<UIntType> ranges ( 100'000 ), out ( ranges.size ( ) );
+    for ( std::size_t i = 0; i < ranges.size ( ); ++i ) {
+        ranges [ i ] = static_cast<UIntType> ( std::numeric_limits<UIntType>::max ( ) - i * 7919 % std::numeric_limits<UIntType>::max ( ) );
+    }
+    ext::bounded_batch ( rng, ranges.data ( ), out.data ( ), out.size ( ) );
+    for ( std::size_t i = 0; i < ranges.size ( ); ++i ) {
+        if ( out [ i ] >= ranges [ i ] ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+inline int check_batch ( std::ostream & out ) {
+    int failures = check ( out, "batch", &fill_batch, 64, bt::suite_ranges ( 64 ) );
+    failures += expect ( out, "batch", "varying 16-bit ranges", batch_in_ranges<std::uint16_t> ( 1 ) );
+    failures += expect ( out, "batch", "varying 32-bit ranges", batch_in_ranges<std::uint32_t> ( 2 ) );
+    return failures + expect ( out, "batch", "varying 64-bit ranges", batch_in_ranges<std::uint64_t> ( 3 ) );
+}
+
+
+// uniform_index_distribution, the cells are mapped back onto [ 0, range ), as their linear
+// index. Fused, over a grid of ( f, range / f ), f the smallest factor of the range (up to
+// 1000), resp. ( 7, 13, range / 91 ), and drawn per axis, where only the first axis, of
+// extent range, is recorded.
+[[ nodiscard ]] inline std::uint64_t smallest_factor ( std::uint64_t range ) {
+    for ( std::uint64_t f = 2; f <= 1000; ++f ) {
+        if ( not ( range % f ) ) {
+            return f;
+        }
+    }
+    return 1;
+}
+
+inline void fill_index ( generator & rng, std::uint64_t range, std::uint64_t draws, std::uint64_t * values ) {
+    const std::uint64_t f = smallest_factor ( range );
+    const ext::uniform_index_distribution<2, std::uint64_t> dis ( f, range / f );
+    while ( draws-- ) {
+        const auto [ x, y ] = dis ( rng );
+        *values++ = x + f * y;
+    }
+}
+
+inline void fill_grid ( generator & rng, std::uint64_t range, std::uint64_t draws, std::uint64_t * values ) {
+    const ext::uniform_index_distribution<3, std::uint64_t> dis ( 7, 13, range / 91 );
+    while ( draws-- ) {
+        const auto [ x, y, z ] = dis ( rng );
+        *values++ = x + 7 * ( y + 13 * z );
+    }
+}
+
+inline void fill_axes ( generator & rng, std::uint64_t range, std::uint64_t draws, std::uint64_t * values ) {
+    const ext::uniform_index_distribution<2, std::uint64_t> dis ( range, std::uint64_t { 1 } << 63 );
+    while ( draws-- ) {
+        *values++ = dis ( rng ) [ 0 ];
+    }
+}
+
+inline int check_index ( std::ostream & out ) {
+    int failures = check ( out, "index", &fill_index, 64, bt::suite_ranges ( 64 ) );
+    failures += check ( out, "index 3-d", &fill_grid, 64, { 91'000, 91 * ( std::uint64_t { 1 } << 40 ) } );
+    failures += check ( out, "index per axis", &fill_axes, 64, bt::suite_ranges ( 64 ) );
+    failures += expect ( out, "index", "fused if the product fits", ext::uniform_index_distribution<3> ( 1920, 1080, 1u << 20 ).is_fused ( ) );
+    return failures + expect ( out, "index", "per axis if it doesn't", not ext::uniform_index_distribution<2, std::uint64_t> ( 6, std::uint64_t { 1 } << 63 ).is_fused ( ) );
+}
+
+
+// uniform_interval_distribution, over [ 0, range + N - 2 ] minus N - 1 points, the gaps after
+// every piece of length range / N, the values are mapped back onto [ 0, range ) by their rank.
+// Two intervals are built by exclude ( ) (the linear search), 32 by include ( ) in reverse
+// order (the binary search).
+template<std::uint64_t N>
+void fill_interval ( generator & rng, std::uint64_t range, std::uint64_t draws, std::uint64_t * values ) {
+    const std::uint64_t length = range / N;
+    ext::uniform_interval_distribution<std::uint64_t> dis ( 0, range + N - 2 );
+    if constexpr ( 2 == N ) {
+        dis.exclude ( length, length );
+    }
+    else {
+        dis = ext::uniform_interval_distribution<std::uint64_t> ( ( N - 1 ) * ( length + 1 ), range + N - 2 ); // the last piece, with the remainder.
+        for ( std::uint64_t j = N - 1; j--; ) {
+            dis.include ( j * ( length + 1 ), j * ( length + 1 ) + length - 1 );
+        }
+    }
+    while ( draws-- ) {
+        const std::uint64_t v = dis ( rng );
+        *values++ = v - std::min ( N - 1, ( v + 1 ) / ( length + 1 ) );
+    }
+}
+
+inline int check_interval ( std::ostream & out ) {
+    std::vector<std::uint64_t> ranges = bt::suite_ranges ( 64 );
+    int failures = check ( out, "interval 2", &fill_interval<2>, 64, ranges );
+    ranges.erase ( ranges.begin ( ) ), ranges.pop_back ( ); // 32 pieces of at least 1 value, and no overflow of range + 30.
+    failures += check ( out, "interval 32", &fill_interval<32>, 64, ranges );
+    ext::uniform_interval_distribution<std::int16_t> dis { { 50, 99 }, { -100, -51 } };
+    generator rng ( 1 );
+    int below = 0;
+    bool in_set = true;
+    for ( int i = 0; i < 100'000; ++i ) {
+        const std::int16_t v = dis ( rng );
+        in_set = in_set and ( ( v >= -100 and v <= -51 ) or ( v >= 50 and v <= 99 ) );
+        below += v < 0;
+    }
+    failures += expect ( out, "interval", "signed intervals in the set", in_set and below > 49'000 and below < 51'000 );
+    dis.include ( -50, 49 );
+    failures += expect ( out, "interval", "adjacent intervals merged", 1 == dis.param ( ).size ( ) and 200 == dis.size ( ) );
+    dis.exclude ( 0, 0 );
+    failures += expect ( out, "interval", "an interval split", 2 == dis.param ( ).size ( ) and 199 == dis.size ( ) );
+    return failures + expect ( out, "interval", "all values, size 0", 0 == ext::uniform_interval_distribution<std::uint16_t> ( ).size ( ) );
+}
+
+
+// uniform_real_distribution_fast, the values in [ 0, 1 ) (filled by generate ( )) are binned
+// onto [ 0, range ), for ranges well within the precision of RealType. Values are in [ a, b ),
+// also where a + ( b - a ) * u rounds to b, in dense mode the small values keep a full mantissa.
+template<typename RealType, bool Dense>
+void fill_real ( generator & rng, std::uint64_t range, std::uint64_t draws, std::uint64_t * values ) {
+    const ext::uniform_real_distribution_fast<RealType, Dense> dis;
+    std::vector<RealType> u ( draws );
+    dis.generate ( rng, u.begin ( ), u.end ( ) );
+    for ( const RealType x : u ) {
+        *values++ = static_cast<std::uint64_t> ( x * static_cast<RealType> ( range ) );
+    }
+}
+
+template<typename RealType, bool Dense>
+[[ nodiscard ]] bool real_in_interval ( RealType a, RealType b ) {
+    const ext::uniform_real_distribution_fast<RealType, Dense> dis ( a, b );
+    generator rng ( 1 );
+    for ( int i = 0; i < 100'000; ++i ) {
+        const RealType x = dis ( rng );
+        if ( x < a or x >= b ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template<bool Dense>
+[[ nodiscard ]] bool real_full_mantissa ( ) {
+    const ext::uniform_real_distribution_fast<double, Dense> dis;
+    generator rng ( 1 );
+    for ( int i = 0; i < 1'000'000; ++i ) {
+        const double x = dis ( rng );
+        if ( x < 0x1p-10 and std::ldexp ( x, 53 ) != std::floor ( std::ldexp ( x, 53 ) ) ) {
+            return true;
+        }
+    }
+    return false;
+}
+
+inline int check_real ( std::ostream & out ) {
+    const std::vector<std::uint64_t> ranges { 6, 1000, 4096 }, wide_ranges { 6, 1000, ( 1u << 20 ) + 1 };
+    int failures = check ( out, "real float", &fill_real<float, false>, 64, ranges );
+    failures += check ( out, "real double", &fill_real<double, false>, 64, wide_ranges );
+    failures += check ( out, "real float dense", &fill_real<float, true>, 64, ranges );
+    failures += check ( out, "real double dense", &fill_real<double, true>, 64, wide_ranges );
+    failures += expect ( out, "real", "float in [ -1.5, 2.5 )", real_in_interval<float, false> ( -1.5f, 2.5f ) );
+    failures += expect ( out, "real", "double in [ 1, 1 + 2^-52 ), rounding to b", real_in_interval<double, false> ( 1.0, std::nextafter ( 1.0, 2.0 ) ) );
+    failures += expect ( out, "real", "dense double in [ -1, 0 )", real_in_interval<double, true> ( -1.0, 0.0 ) );
+    failures += expect ( out, "real", "dense, values below 2^-10 with a full mantissa", real_full_mantissa<true> ( ) );
+    return failures + expect ( out, "real", "not dense, without", not real_full_mantissa<false> ( ) );
+}
+
+
+// bernoulli_fast, fair coins (p = 1 / 2, by chunks of the cached word, resp. bit-masks) are
+// composed into values over [ 0, range ), range a power of 2. The frequencies of other p match,
+// ( k, n ) equals p = k / 2^n, exactly, also for n > 53 (checked against an engine returning
+// a fixed word).
+inline void fill_coins ( generator & rng, std::uint64_t range, std::uint64_t draws, std::uint64_t * values ) {
+    ext::bernoulli_fast coin;
+    while ( draws-- ) {
+        std::uint64_t v = 0;
+        for ( std::uint64_t r = range; r > 1; r >>= 1 ) {
+            v = ( v << 1 ) | coin ( rng );
+        }
+        *values++ = v;
+    }
+}
+
+inline void fill_masks ( generator & rng, std::uint64_t range, std::uint64_t draws, std::uint64_t * values ) {
+    const ext::bernoulli_fast coin;
+    const int shift = 64 - static_cast<int> ( std::log2 ( range ) );
+    while ( draws-- ) {
+        *values++ = coin.mask ( rng ) >> shift;
+    }
+}
+
+struct constant_engine {
+    using result_type = std::uint64_t;
+    [[ nodiscard ]] static constexpr result_type min ( ) noexcept { return 0; }
+    [[ nodiscard ]] static constexpr result_type max ( ) noexcept { return std::numeric_limits<result_type>::max ( ); }
+    [[ nodiscard ]] result_type operator ( ) ( ) noexcept { return value; }
+    result_type value;
+};
+
+// Returns true if the frequency of true is within 5 sigma of p, per draw and per mask.
+[[ nodiscard ]] inline bool bernoulli_frequency ( ext::bernoulli_fast dis, double p ) {
+    generator rng ( 1 );
+    constexpr int n = 1'000'000;
+    std::uint64_t draws = 0, bits = 0;
+    for ( int i = 0; i < n; ++i ) {
+        draws += dis ( rng );
+    }
+    for ( int i = 0; i < n / 64; ++i ) {
+        bits += std::bitset<64> ( dis.mask ( rng ) ).count ( );
+    }
+    const double sigma = std::sqrt ( p * ( 1.0 - p ) / n );
+    return std::abs ( draws / double ( n ) - p ) <= 5 * sigma + 1e-12 and std::abs ( bits / double ( n / 64 * 64 ) - p ) <= 5 * sigma + 1e-12;
+}
+
+inline int check_bernoulli ( std::ostream & out ) {
+    const std::vector<std::uint64_t> ranges { 2, 64, 1u << 16 };
+    int failures = check ( out, "bernoulli", &fill_coins, 64, ranges );
+    failures += check ( out, "bernoulli mask", &fill_masks, 64, ranges );
+    failures += expect ( out, "bernoulli", "p = 3 / 8", bernoulli_frequency ( ext::bernoulli_fast ( 3, 3 ), 0.375 ) );
+    failures += expect ( out, "bernoulli", "p = 0.3", bernoulli_frequency ( ext::bernoulli_fast ( 0.3 ), 0.3 ) );
+    failures += expect ( out, "bernoulli", "p = 0 and p = 1", bernoulli_frequency ( ext::bernoulli_fast ( 0, 5 ), 0.0 ) and bernoulli_frequency ( ext::bernoulli_fast ( 32, 5 ), 1.0 ) );
+    generator gen ( 2 ), reference_gen ( 2 );
+    ext::bernoulli_fast dis ( 12345, 50 ), reference ( std::ldexp ( 12345.0, -50 ) );
+    bool equal = true;
+    for ( int i = 0; i < 100'000; ++i ) {
+        equal = equal and dis ( gen ) == reference ( reference_gen );
+    }
+    failures += expect ( out, "bernoulli", "( k, n ) the sequence of p = k / 2^n", equal );
+    constant_engine top { ~std::uint64_t { 0 } - 16 }, below { ~std::uint64_t { 0 } - 15 }; // 2^64 - 17, 2^64 - 16.
+    ext::bernoulli_fast almost ( ( std::uint64_t { 1 } << 60 ) - 1, 60 ); // p = 1 - 2^-60, 1.0 as a double.
+    return failures + expect ( out, "bernoulli", "( 2^60 - 1, 60 ) exact", almost ( top ) and not almost ( below ) );
+}
+
+
+// fastrange, of 32- and 64-bit engine values, by the value and by the array, over the ranges
+// up to 2^(digits/2) + 1 only, it doesn't reject, its bias of up to n / 2^digits is detected
+// by the suite for larger ranges. prepared_range reduces as fastrange, also for powers of 2 (by
+// a shift) and 1.
+inline void fill_fastrange_32 ( generator & rng, std::uint64_t range, std::uint64_t draws, std::uint64_t * values ) {
+    while ( draws-- ) {
+        *values++ = ext::fastrange ( static_cast<std::uint32_t> ( rng ( ) >> 32 ), static_cast<std::uint32_t> ( range ) );
+    }
+}
+
+inline void fill_fastrange_64 ( generator & rng, std::uint64_t range, std::uint64_t draws, std::uint64_t * values ) {
+    for ( std::uint64_t i = 0; i < draws; ++i ) {
+        values [ i ] = rng ( );
+    }
+    ext::fastrange ( values, draws, range, values );
+}
+
+template<typename UIntType>
+[[ nodiscard ]] bool prepared_as_fastrange ( ) {
+    generator rng ( 1 );
+    std::vector<UIntType> x ( 1'000 ), out ( x.size ( ) );
+    for ( UIntType & v : x ) {
+        v = static_cast<UIntType> ( rng ( ) );
+    }
+    for ( const UIntType n : { UIntType { 1 }, UIntType { 2 }, UIntType { 1024 }, UIntType ( UIntType { 1 } << ( std::numeric_limits<UIntType>::digits - 1 ) ),
+                               UIntType { 3 }, UIntType { 1000 }, std::numeric_limits<UIntType>::max ( ) } ) {
+        const ext::prepared_range<UIntType> range ( n );
+        range ( x.data ( ), x.size ( ), out.data ( ) );
+        for ( std::size_t i = 0; i < x.size ( ); ++i ) {
+            if ( range ( x [ i ] ) != ext::fastrange ( x [ i ], n ) or out [ i ] != range ( x [ i ] ) ) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+inline int check_fastrange ( std::ostream & out ) {
+    const auto small_ranges = [ ] ( int width ) {
+        std::vector<std::uint64_t> ranges = bt::suite_ranges ( width );
+        ranges.resize ( 3 );
+        return ranges;
+    };
+    int failures = check ( out, "fastrange 32", &fill_fastrange_32, 32, small_ranges ( 32 ) );
+    failures += check ( out, "fastrange 64", &fill_fastrange_64, 64, small_ranges ( 64 ) );
+    failures += expect ( out, "fastrange", "floor ( x * n / 2^32 )", 0xFFFF'FFFEu == ext::fastrange ( 0xFFFF'FFFFu, 0xFFFF'FFFFu ) and 1u == ext::fastrange ( 0x8000'0000u, 3u ) );
+    failures += expect ( out, "fastrange", "floor ( x * n / 2^64 )", ~std::uint64_t { 1 } == ext::fastrange ( ~std::uint64_t { 0 }, ~std::uint64_t { 0 } ) and 1u == ext::fastrange ( std::uint64_t { 1 } << 63, std::uint64_t { 3 } ) );
+    failures += expect ( out, "fastrange", "32-bit prepared_range", prepared_as_fastrange<std::uint32_t> ( ) );
+    return failures + expect ( out, "fastrange", "64-bit prepared_range", prepared_as_fastrange<std::uint64_t> ( ) );
+}
+
+
+// algorithm::canon, over all 16-bit ranges (275 draws each, some 18M draws). The k words drawn
+// are recorded, the result must equal floor ( range * X ) for every X in [ X_k, X_k + 2^-16k ),
+// X_k = 0.x0x1...x(k-1), i.e. be the exact floor ( range * X ) of the infinite fraction X,
+// whatever the words not drawn. automatic draws as canon for 64-bit ranges, lemire is the default.
+struct recording_engine {
+    using result_type = std::uint16_t;
+    [[ nodiscard ]] static constexpr result_type min ( ) noexcept { return 0; }
+    [[ nodiscard ]] static constexpr result_type max ( ) noexcept { return std::numeric_limits<result_type>::max ( ); }
+    [[ nodiscard ]] result_type operator ( ) ( ) noexcept {
+        const result_type w = static_cast<result_type> ( rng ( ) );
+        if ( size < 4 ) {
+            words [ size ] = w;
+        }
+        ++size;
+        return w;
+    }
+    generator rng;
+    result_type words [ 4 ] { };
+    int size = 0;
+};
+
+[[ nodiscard ]] inline bool canon_exact_floor ( ) {
+    recording_engine e { generator ( 1 ) };
+    for ( std::uint32_t range = 1; range < 0x1'0000; ++range ) {
+        for ( int i = 0; i < 275; ++i ) {
+            e.size = 0;
+            const std::uint16_t r = ext::algorithm::canon::generate ( e, static_cast<std::uint16_t> ( range ) );
+            if ( e.size > 4 ) { // 1 in 2^48.
+                continue;
+            }
+            std::uint64_t x = 0;
+            for ( int k = 0; k < e.size; ++k ) {
+                x = ( x << 16 ) | e.words [ k ];
+            }
+            const int shift = 16 * e.size;
+            std::uint64_t l = 0, h = ext::detail::wide_multiply<std::uint64_t> ( x, range, l ), l2 = l + ( range - 1 );
+            const std::uint64_t h2 = h + ( l2 < l );
+            const auto floor_of = [ shift ] ( std::uint64_t hi, std::uint64_t lo ) {
+                return 64 == shift ? hi : ( hi << ( 64 - shift ) ) | ( lo >> shift );
+            };
+            if ( r != floor_of ( h, l ) or r != floor_of ( h2, l2 ) ) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+inline int check_canon ( std::ostream & out ) {
+    int failures = expect ( out, "canon", "floor ( range * X ), all 16-bit ranges", canon_exact_floor ( ) );
+    generator gen ( 1 ), reference_gen ( 1 );
+    const ext::uniform_int_distribution_fast<std::uint64_t, ext::algorithm::automatic> dis ( 0, 999'999'999'999 );
+    const ext::uniform_int_distribution_fast<std::uint64_t, ext::algorithm::canon> reference ( 0, 999'999'999'999 );
+    bool equal = true;
+    for ( int i = 0; i < 100'000; ++i ) {
+        equal = equal and dis ( gen ) == reference ( reference_gen );
+    }
+    failures += expect ( out, "canon", "automatic, canon for 64-bit ranges", equal );
+    return failures + expect ( out, "canon", "lemire, the default", std::is_same<ext::uniform_int_distribution_fast<>::algorithm_type, ext::algorithm::lemire>::value );
+}
+
+
+// The distributions of the bucket test (std, fast, bounded and every algorithm policy of
+// uniform_int_distribution_fast) over 16-, 32- and 64-bit ranges.
+template<typename IntType>
+int check_kernels ( std::ostream & out ) {
+    int failures = 0;
+    for ( const auto & [ name, kernel ] : bt::kernel_table<IntType> ( ) ) {
+        failures += check ( out, name, kernel.fill, std::numeric_limits<IntType>::digits, bt::suite_ranges ( std::numeric_limits<IntType>::digits ) );
+    }
+    return failures;
+}
+
+inline int check_policies ( std::ostream & out ) {
+    return check_kernels<std::uint16_t> ( out ) + check_kernels<std::uint32_t> ( out ) + check_kernels<std::uint64_t> ( out );
+}
+
+
+// ext::bounded over signed ranges, [ -( range / 2 ), range - range / 2 ), and the full 16-bit
+// range, both shifted onto [ 0, range ). bounded ( rng, n ) draws as bounded ( rng, 0, n - 1 ),
+// the full 64-bit range returns the engine words.
+inline void fill_bounded_signed ( generator & rng, std::uint64_t range, std::uint64_t draws, std::uint64_t * values ) {
+    const std::uint64_t half = range / 2;
+    const std::int64_t a = static_cast<std::int64_t> ( 0 - half ), b = static_cast<std::int64_t> ( range - half - 1 );
+    while ( draws-- ) {
+        *values++ = static_cast<std::uint64_t> ( ext::bounded ( rng, a, b ) ) + half;
+    }
+}
+
+inline void fill_bounded_full_16 ( generator & rng, std::uint64_t, std::uint64_t draws, std::uint64_t * values ) {
+    while ( draws-- ) {
+        *values++ = static_cast<std::uint64_t> ( ext::bounded<generator, std::int16_t> ( rng, std::numeric_limits<std::int16_t>::min ( ), std::numeric_limits<std::int16_t>::max ( ) ) + 0x8000 );
+    }
+}
+
+inline int check_bounded ( std::ostream & out ) {
+    int failures = check ( out, "bounded signed", &fill_bounded_signed, 64, bt::suite_ranges ( 64 ) );
+    failures += check ( out, "bounded full 16", &fill_bounded_full_16, 32, { 0x1'0000 } );
+    generator gen ( 1 ), reference_gen ( 1 );
+    bool equal = true, full = true;
+    for ( std::uint64_t i = 1; i <= 100'000; ++i ) {
+        const std::uint64_t n = i * 0x9E37'79B9'7F4A'7C15 | 1; // odd ranges of every width.
+        equal = equal and ext::bounded ( gen, n ) == ext::bounded ( reference_gen, std::uint64_t { 0 }, n - 1 );
+    }
+    failures += expect ( out, "bounded", "[ 0, n ) as [ 0, n - 1 ]", equal );
+    for ( int i = 0; i < 1'000; ++i ) {
+        full = full and static_cast<std::uint64_t> ( ext::bounded ( gen, std::numeric_limits<std::int64_t>::min ( ), std::numeric_limits<std::int64_t>::max ( ) ) ) == reference_gen ( );
+    }
+    return failures + expect ( out, "bounded", "the full range, the engine words", full );
+}
+
+
+// The distribution (with the default and another policy) and ext::bounded in constant
+// expressions, a table of bounded values is built at compile time, its values are checked by
+// static_assert, and to be those drawn at run time.
+struct bounded_table {
+    std::uint64_t dice [ 64 ], large [ 64 ], shuffle [ 64 ];
+};
+
+[[ nodiscard ]] constexpr bounded_table make_bounded_table ( std::uint64_t seed ) {
+    generator rng ( seed );
+    const ext::uniform_int_distribution_fast<std::uint64_t> dice ( 1, 6 );
+    const ext::uniform_int_distribution_fast<std::uint64_t, ext::algorithm::canon> large ( 0, ( std::uint64_t { 1 } << 63 ) + 12345 );
+    bounded_table t { };
+    for ( std::uint64_t i = 0; i < 64; ++i ) {
+        t.dice [ i ] = dice ( rng );
+        t.large [ i ] = large ( rng );
+        t.shuffle [ i ] = ext::bounded ( rng, 64 - i );
+    }
+    return t;
+}
+
+inline constexpr bounded_table constant_table = make_bounded_table ( 42 );
+
+[[ nodiscard ]] constexpr bool in_bounds ( const bounded_table & t ) {
+    for ( std::uint64_t i = 0; i < 64; ++i ) {
+        if ( t.dice [ i ] < 1 or t.dice [ i ] > 6 or t.large [ i ] > ( std::uint64_t { 1 } << 63 ) + 12345 or t.shuffle [ i ] >= 64 - i ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert ( in_bounds ( constant_table ), "the constant table is out of bounds." );
+
+inline int check_constant ( std::ostream & out ) {
+    volatile std::uint64_t seed = 42;
+    const bounded_table t = make_bounded_table ( seed ); // at run time.
+    bool equal = true;
+    for ( std::size_t i = 0; i < 64; ++i ) {
+        equal = equal and t.dice [ i ] == constant_table.dice [ i ] and t.large [ i ] == constant_table.large [ i ] and t.shuffle [ i ] == constant_table.shuffle [ i ];
+    }
+    return expect ( out, "constexpr", "the table built at compile time, at run time", equal );
+}
+
+
+// random_string over alphabets of range characters, the bytes ( 37 * i + 11 ) % 256, mapped
+// back onto their index i. The ranges take the bit-sliced path (powers of 2), the digits of
+// one draw, the pshufb lookups (up to 16 and up to 64 characters) and the scalar lookup.
+inline void fill_string ( generator & rng, std::uint64_t range, std::uint64_t draws, std::uint64_t * values ) {
+    std::string alphabet;
+    unsigned char index [ 256 ] { };
+    for ( std::uint64_t i = 0; i < range; ++i ) {
+        alphabet.push_back ( static_cast<char> ( ( 37 * i + 11 ) % 256 ) );
+        index [ ( 37 * i + 11 ) % 256 ] = static_cast<unsigned char> ( i );
+    }
+    std::string s = ext::random_string ( alphabet ) ( rng, draws );
+    for ( const char c : s ) {
+        *values++ = index [ static_cast<unsigned char> ( c ) ];
+    }
+}
+
+inline int check_string ( std::ostream & out ) {
+    int failures = check ( out, "string", &fill_string, 8, { 2, 10, 16, 62, 64, 200, 256 } );
+    failures += expect ( out, "string", "characters per word, 16 (hex), 10 (base62 and base64)",
+                         16 == ext::random_string ( "0123456789abcdef" ).chars_per_word ( ) and
+                         10 == ext::random_string ( "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz" ).chars_per_word ( ) and
+                         10 == ext::random_string ( "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz+/" ).chars_per_word ( ) );
+    generator rng ( 1 );
+    const std::string s = ext::random_string ( "x" ) ( rng, 100 );
+    return failures + expect ( out, "string", "a single character alphabet", std::string ( 100, 'x' ) == s );
+}
+
+
+// lookahead_index (over a table of a single element, the prefetches all hit it), the indices
+// are those of uniform_int_distribution_fast, also after the distance grows, after it shrinks
+// the pending indices beyond the distance are skipped.
+inline void fill_lookahead ( generator & rng, std::uint64_t range, std::uint64_t draws, std::uint64_t * values ) {
+    static const unsigned char table [ 1 ] { };
+    ext::lookahead_index<generator, std::uint64_t> index ( rng, range, table, 0 );
+    while ( draws-- ) {
+        *values++ = index ( );
+    }
+}
+
+inline int check_lookahead ( std::ostream & out ) {
+    int failures = check ( out, "lookahead", &fill_lookahead, 64, bt::suite_ranges ( 64 ) );
+    static const unsigned char table [ 1 ] { };
+    generator gen ( 1 ), reference_gen ( 1 );
+    ext::lookahead_index<generator, std::uint32_t> index ( gen, 1'000'000, table, 0, 16 );
+    const ext::uniform_int_distribution_fast<std::uint32_t> reference ( 0, 999'999 );
+    bool equal = true;
+    for ( int i = 0; i < 10'000; ++i ) {
+        equal = equal and index ( ) == reference ( reference_gen );
+    }
+    index.distance ( 64 );
+    for ( int i = 0; i < 10'000; ++i ) {
+        equal = equal and index ( ) == reference ( reference_gen );
+    }
+    failures += expect ( out, "lookahead", "the sequence of uniform_int_distribution_fast", equal and 64 == index.distance ( ) );
+    index.distance ( 8 ); // keeps the 8 oldest of the 64 pending, skips 56.
+    bool skipped = true;
+    for ( int i = 0; i < 8; ++i ) {
+        skipped = skipped and index ( ) == reference ( reference_gen );
+    }
+    for ( int i = 0; i < 56; ++i ) {
+        ( void ) reference ( reference_gen );
+    }
+    for ( int i = 0; i < 10'000; ++i ) {
+        skipped = skipped and index ( ) == reference ( reference_gen );
+    }
+    return failures + expect ( out, "lookahead", "pending indices skipped as the distance shrinks", skipped );
+}
+
+
+// detail::wide_multiply_portable (the 64 x 64 -> 128 bit multiply of 32-bit targets and of
+// constant expressions on MSVC) against a reference, unsigned __int128 where available, 16-bit
+// limbs otherwise, over the edge values (all pairs) and 10M random pairs, of which the high
+// halves of b are zero in 1 in 4 (the two partial product path).
+static_assert ( [ ] { std::uint64_t l = 0; const std::uint64_t h = ext::detail::wide_multiply_portable ( ~std::uint64_t { 0 }, ~std::uint64_t { 0 }, l ); return h == ~std::uint64_t { 1 } and 1 == l; } ( ),
+                "( 2^64 - 1 )^2 is 2^128 - 2^65 + 1." );
+static_assert ( [ ] { std::uint64_t l = 0; const std::uint64_t h = ext::detail::wide_multiply_portable ( ~std::uint64_t { 0 }, 0xFFFF'FFFF, l ); return 0xFFFF'FFFE == h and 0xFFFF'FFFF'0000'0001 == l; } ( ),
+                "( 2^64 - 1 ) * ( 2^32 - 1 ) is 2^96 - 2^64 - 2^32 + 1." );
+
+[[ nodiscard ]] inline std::uint64_t reference_multiply ( std::uint64_t a, std::uint64_t b, std::uint64_t & l ) {
+    #if defined ( __SIZEOF_INT128__ )
+    const unsigned __int128 m = static_cast<unsigned __int128> ( a ) * b;
+    l = static_cast<std::uint64_t> ( m );
+    return static_cast<std::uint64_t> ( m >> 64 );
+    #else
+    std::uint32_t r [ 8 ] { }; // 16-bit limbs, least significant first.
+    for ( int i = 0; i < 4; ++i ) {
+        std::uint32_t carry = 0;
+        for ( int j = 0; j < 4; ++j ) {
+            const std::uint32_t t = static_cast<std::uint32_t> ( ( a >> 16 * i ) & 0xFFFF ) * static_cast<std::uint32_t> ( ( b >> 16 * j ) & 0xFFFF ) + r [ i + j ] + carry;
+            r [ i + j ] = t & 0xFFFF;
+            carry = t >> 16;
+        }
+        r [ i + 4 ] = carry;
+    }
+    l = std::uint64_t { r [ 0 ] } | std::uint64_t { r [ 1 ] } << 16 | std::uint64_t { r [ 2 ] } << 32 | std::uint64_t { r [ 3 ] } << 48;
+    return std::uint64_t { r [ 4 ] } | std::uint64_t { r [ 5 ] } << 16 | std::uint64_t { r [ 6 ] } << 32 | std::uint64_t { r [ 7 ] } << 48;
+    #endif
+}
+
+[[ nodiscard ]] inline bool multiplies ( std::uint64_t a, std::uint64_t b ) {
+    std::uint64_t l = 0, reference_l = 0;
+    const std::uint64_t h = ext::detail::wide_multiply_portable ( a, b, l );
+    return h == reference_multiply ( a, b, reference_l ) and l == reference_l;
+}
+
+inline int check_multiply ( std::ostream & out ) {
+    const std::uint64_t edges [ ] = { 0, 1, 2, 0xFFFF'FFFF, 0x1'0000'0000, 0x1'0000'0001, 0xFFFF'FFFF'0000'0000,
+                                      std::uint64_t { 1 } << 63, ~std::uint64_t { 1 }, ~std::uint64_t { 0 } };
+    bool equal = true;
+    for ( const std::uint64_t a : edges ) {
+        for ( const std::uint64_t b : edges ) {
+            equal = equal and multiplies ( a, b );
+        }
+    }
+    int failures = expect ( out, "multiply", "edge values", equal );
+    generator rng ( 1 );
+    for ( int i = 0; i < 10'000'000; ++i ) {
+        const std::uint64_t a = rng ( ), b = rng ( );
+        equal = equal and multiplies ( a, b & 3 ? b : b >> 32 );
+    }
+    return failures + expect ( out, "multiply", "10M random pairs", equal );
+}
+
+
+// sf::accumulator, the exact sums give the same results, one value at a time, by the block and
+// merged from (uneven) parts, and agree with welford, over values below 2^32 (the 64-bit lanes)
+// and beyond (one at a time).
+[[ nodiscard ]] inline bool accumulates ( int shift ) {
+    generator rng ( 0xACC );
+    std::vector<std::uint64_t> values ( 100'003 );
+    for ( std::uint64_t & v : values ) {
+        v = rng ( ) >> shift;
+    }
+    sf::accumulator once, incremental, parts [ 3 ];
+    sf::welford reference;
+    once ( values.data ( ), values.size ( ) );
+    for ( const std::uint64_t v : values ) {
+        incremental ( v );
+        reference ( v );
+    }
+    const std::size_t cuts [ 4 ] = { 0, 1'234, 61'000, values.size ( ) };
+    for ( int i = 0; i < 3; ++i ) {
+        parts [ i ] ( values.data ( ) + cuts [ i ], cuts [ i + 1 ] - cuts [ i ] );
+    }
+    parts [ 0 ].merge ( parts [ 2 ] );
+    parts [ 0 ].merge ( parts [ 1 ] );
+    const auto r = once.result ( ), w = reference.result ( );
+    const auto close = [ ] ( long double a, long double b ) { return std::abs ( a - b ) <= 1e-9L * std::abs ( b ); };
+    return r == incremental.result ( ) and r == parts [ 0 ].result ( ) and values.size ( ) == parts [ 0 ].count ( ) and std::get<0> ( r ) == std::get<0> ( w ) and
+           std::get<1> ( r ) == std::get<1> ( w ) and close ( std::get<2> ( r ), std::get<2> ( w ) ) and close ( std::get<3> ( r ), std::get<3> ( w ) ) and
+           close ( std::get<4> ( r ), std::get<4> ( w ) ) and close ( std::get<5> ( r ), std::get<5> ( w ) );
+}
+
+inline int check_accumulator ( std::ostream & out ) {
+    const int failures = expect ( out, "accumulator", "values below 2^32, one-shot, incremental, merged and welford agree", accumulates ( 32 ) );
+    return failures + expect ( out, "accumulator", "values up to 2^48, one-shot, incremental, merged and welford agree", accumulates ( 16 ) );
+}
+
+
+// sf::latency_histogram, of a heavy-tailed (Pareto) sample recorded into two histograms and
+// merged, every percentile is within the relative precision 2^( 1 - SubBucketBits ) of that of
+// the sorted sample, the count, minimum and maximum are exact.
+inline int check_latency ( std::ostream & out ) {
+    generator rng ( 0x1A7E );
+    std::vector<std::uint64_t> values ( 1'000'003 );
+    sf::latency_histogram<> histograms [ 2 ];
+    for ( std::size_t i = 0; i < values.size ( ); ++i ) {
+        const double u = static_cast<double> ( ( rng ( ) >> 11 ) + 1 ) * 0x1.0p-53; // in ( 0, 1 ].
+        values [ i ] = 50 + static_cast<std::uint64_t> ( 20.0 * std::pow ( u, -1.0 / 1.2 ) );
+        histograms [ i % 3 == 0 ].record ( values [ i ] );
+    }
+    histograms [ 0 ].merge ( histograms [ 1 ] );
+    const sf::latency_histogram<> & h = histograms [ 0 ];
+    std::sort ( values.begin ( ), values.end ( ) );
+    double worst = 0.0;
+    for ( const double p : { 0.0, 1.0, 10.0, 25.0, 50.0, 75.0, 90.0, 99.0, 99.9, 99.99, 99.999, 100.0 } ) {
+        const std::size_t rank = std::max<std::size_t> ( 1, static_cast<std::size_t> ( std::ceil ( p / 100.0 * values.size ( ) ) ) );
+        const double exact = static_cast<double> ( values [ rank - 1 ] );
+        worst = std::max ( worst, std::abs ( static_cast<double> ( h.percentile ( p ) ) - exact ) / exact );
+    }
+    int failures = expect ( out, "latency", "the count, min and max of the merged histograms",
+                            values.size ( ) == h.count ( ) and values.front ( ) == h.min ( ) and values.back ( ) == h.max ( ) );
+    const std::string property = "the percentiles within " + std::to_string ( h.precision ) + " of the sorted sample, at most " + std::to_string ( worst );
+    return failures + expect ( out, "latency", property, worst <= h.precision );
+}
+
+
+// The partitioned bucket test, over a range of counters of at least twice the size of the last
+// level cache, counts as the direct one (single-threaded, such that the direct mode doesn't
+// allocate a shard per thread). The throughputs are reported, not checked, the benchmark judges
+// the speed.
+[[ nodiscard ]] inline std::uint64_t last_level_cache ( ) {
+    #if defined ( _SC_LEVEL3_CACHE_SIZE )
+    const long size = sysconf ( _SC_LEVEL3_CACHE_SIZE );
+    if ( size > 0 ) {
+        return static_cast<std::uint64_t> ( size );
+    }
+    #endif
+    return std::uint64_t { 1 } << 25; // unknown, 32MiB.
+}
+
+inline int check_partitioned ( std::ostream & out ) {
+    bt::options o;
+    o.range = std::uint64_t { 1 } << 24;
+    while ( o.range * sizeof ( bt::counter_type ) < 2 * last_level_cache ( ) ) {
+        o.range *= 2;
+    }
+    o.draws = 2 * o.range;
+    o.threads = 1;
+    const bt::kernel_type kernel = bt::find_kernel ( "fast" );
+    double throughput [ 2 ];
+    std::vector<bt::counter_type> counts [ 2 ];
+    for ( int partitioned = 0; partitioned < 2; ++partitioned ) {
+        o.partitioned = partitioned;
+        const auto start = std::chrono::steady_clock::now ( );
+        counts [ partitioned ] = bt::run ( o, kernel );
+        throughput [ partitioned ] = o.draws / std::chrono::duration<double, std::micro> ( std::chrono::steady_clock::now ( ) - start ).count ( );
+    }
+    out.width ( 17 ), out << std::left << "partitioned" << std::right << "range " << o.range << ", " << throughput [ 1 ] << " against " << throughput [ 0 ] << " Mdraws/s direct\n";
+    return expect ( out, "partitioned", "the counts of the direct bucket test", counts [ 0 ] == counts [ 1 ] );
+}
+
+
+// The partitioned bucket test into a mapped_histogram of 8- and 16-bit cells, counts as the
+// direct one, also where the 8-bit cells wrap (some 600 draws per bucket, beyond their mean
+// limit, every page of carries is allocated).
+template<typename Cell>
+[[ nodiscard ]] bool mapped_counts ( const bt::options & o, const std::vector<bt::counter_type> & counts ) {
+    const bt::mapped_histogram<Cell> mapped = bt::run_mapped<Cell> ( o, bt::find_kernel ( "fast" ) );
+    std::size_t i = 0;
+    bool equal = mapped.buckets ( ) == counts.size ( );
+    mapped.for_each ( [ & ] ( bt::counter_type c ) {
+        equal = equal and c == counts [ i++ ];
+    } );
+    const bool wraps = 8 == std::numeric_limits<Cell>::digits;
+    return equal and ( mapped.overflows ( ) > 0 ) == wraps and mapped.carry_pages ( ) == ( wraps ? ( counts.size ( ) + mapped.page_size - 1 ) / mapped.page_size : 0 );
+}
+
+inline int check_mapped ( std::ostream & out ) {
+    bt::options o;
+    o.range = 100'000;
+    o.draws = 60'000'000;
+    o.threads = 2;
+    const std::vector<bt::counter_type> counts = bt::run ( o, bt::find_kernel ( "fast" ) );
+    o.partitioned = true;
+    const int failures = expect ( out, "mapped", "8-bit cells, the counts of the direct bucket test", mapped_counts<std::uint8_t> ( o, counts ) );
+    return failures + expect ( out, "mapped", "16-bit cells, the counts of the direct bucket test", mapped_counts<std::uint16_t> ( o, counts ) );
+}
+
+
+// The bucket test, direct and partitioned, counts the same at any number of threads, also if
+// the draws are not a multiple of the chunk (every chunk has a stream of its own).
+[[ nodiscard ]] inline bool same_at_threads ( bt::options o, unsigned threads ) {
+    o.threads = 1;
+    const std::vector<bt::counter_type> counts = bt::run ( o, bt::find_kernel ( "fast" ) );
+    o.threads = threads;
+    return counts == bt::run ( o, bt::find_kernel ( "fast" ) );
+}
+
+inline int check_threads ( std::ostream & out ) {
+    bt::options o;
+    o.range = 100'000;
+    o.chunk = std::uint64_t { 1 } << 16;
+    o.draws = 37 * o.chunk + 12'345;
+    int failures = 0;
+    for ( const bool partitioned : { false, true } ) {
+        o.partitioned = partitioned;
+        for ( const unsigned threads : { 3u, 8u } ) {
+            const std::string property = std::string ( partitioned ? "partitioned" : "direct" ) + ", the counts at 1 and at " + std::to_string ( threads ) + " threads";
+            failures += expect ( out, "threads", property, same_at_threads ( o, threads ) );
+        }
+    }
+    return failures;
+}
+
+
+// The uniformity test suite flags biased kernels, rng ( ) % range over a range of 3 * 2^62 (the
+// values below 2^62 are twice as likely as the others), and lemire with half its threshold over
+// a range near 2^64 * 2 / 3 (every other value is more likely, over stretches of the range), and
+// passes the unbiased kernel over the same ranges.
+inline constexpr std::uint64_t modulo_range = std::uint64_t { 3 } << 62, multiply_range = 0xAAAA'AAAA'AAAA'AAAB;
+
+inline void fill_modulo ( generator & rng, std::uint64_t range, std::uint64_t draws, std::uint64_t * values ) {
+    while ( draws-- ) {
+        *values++ = rng ( ) % range;
+    }
+}
+
+inline void fill_half_threshold ( generator & rng, std::uint64_t range, std::uint64_t draws, std::uint64_t * values ) {
+    const std::uint64_t t = ext::detail::threshold ( range ) / 2;
+    while ( draws-- ) {
+        std::uint64_t l = 0, h = ext::detail::wide_multiply<std::uint64_t> ( rng ( ), range, l );
+        while ( l < t ) {
+            h = ext::detail::wide_multiply<std::uint64_t> ( rng ( ), range, l );
+        }
+        *values++ = h;
+    }
+}
+
+[[ nodiscard ]] inline bool flagged ( std::ostream & out, std::string_view name, fill_type fill, std::uint64_t range ) {
+    bt::options o;
+    o.draws = check_draws;
+    o.chunk = bt::partition_block;
+    bt::suite_result r = bt::test ( o, { nullptr, fill, nullptr }, 64, range );
+    r.distribution = name;
+    bt::report ( out, r );
+    return r.min_p ( ) < bt::suite_alpha;
+}
+
+inline int check_biased ( std::ostream & out ) {
+    const int failures = expect ( out, "biased", "rng ( ) % range flagged", flagged ( out, "modulo", &fill_modulo, modulo_range ) );
+    return failures + expect ( out, "biased", "lemire with half the threshold flagged", flagged ( out, "half_threshold", &fill_half_threshold, multiply_range ) );
+}
+
+inline int check_unbiased ( std::ostream & out ) {
+    int failures = 0;
+    for ( const std::uint64_t range : { modulo_range, multiply_range } ) {
+        failures += expect ( out, "unbiased", "uniform_int_distribution_fast not flagged", not flagged ( out, "fast", bt::find_kernel ( "fast" ).fill, range ) );
+    }
+    return failures;
+}
+
+
+struct component {
+    std::string_view name;
+    int ( * check ) ( std::ostream & out );
+};
+
+inline const component components [ ] = {
+    { "buffered", &check_buffered },
+    { "producer", &check_producer },
+    { "batch", &check_batch },
+    { "index", &check_index },
+    { "interval", &check_interval },
+    { "real", &check_real },
+    { "bernoulli", &check_bernoulli },
+    { "fastrange", &check_fastrange },
+    { "string", &check_string },
+    { "lookahead", &check_lookahead },
+    { "canon", &check_canon },
+    { "bounded", &check_bounded },
+    { "constexpr", &check_constant },
+    { "multiply", &check_multiply },
+    { "policies", &check_policies },
+    { "accumulator", &check_accumulator },
+    { "latency", &check_latency },
+    { "partitioned", &check_partitioned },
+    { "mapped", &check_mapped },
+    { "threads", &check_threads },
+    { "biased", &check_biased },
+    { "unbiased", &check_unbiased }
+};
+
+// Runs the checks of the component called name (or of all), returns the number of failures,
+// -1 if there is no such component.
+inline int run ( std::ostream & out, std::string_view name ) {
+    int failures = -1;
+    bt::report_header ( out );
+    for ( const component & c : components ) {
+        if ( "all" == name or c.name == name ) {
+            failures = std::max ( failures, 0 ) + c.check ( out );
+        }
+    }
+    return failures;
+}
+} // namespace ck
@@ -0,0 +1,122 @@
+
+// MIT License
+//
+// Maps 32- or 64-bit values (f.e. hashes) onto [ 0, n ) without a modulo, as the high half of
+// the product x * n, the reduction at the heart of Lemire's bounded_rand:
+// https://lemire.me/blog/2016/06/27/a-fast-alternative-to-the-modulo-reduction/
+//
+// Copyright (c) 2018 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <limits>
+#include <type_traits>
+
+#include "uniform_int_distribution_fast.hpp"
+
+#if _HAS_EXCEPTIONS == 0
+    #define NOEXCEPT
+#else
+    #define NOEXCEPT noexcept
+#endif
+
+
+namespace ext {
+
+// Returns floor ( x * n / 2^32 ), resp. floor ( x * n / 2^64 ), a value in [ 0, n ), which
+// is fair if x is uniformly distributed (up to a bias of at most n / 2^digits).
+[[ nodiscard ]] inline std::uint32_t fastrange ( std::uint32_t x, std::uint32_t n ) NOEXCEPT {
+    return static_cast<std::uint32_t> ( ( std::uint64_t { x } * std::uint64_t { n } ) >> 32 );
+}
+[[ nodiscard ]] inline std::uint64_t fastrange ( std::uint64_t x, std::uint64_t n ) NOEXCEPT {
+    std::uint64_t l;
+    return detail::wide_multiply<std::uint64_t> ( x, n, l );
+}
+
+// Reduces [ first, first + count ) onto [ 0, n ), into out (which may equal first). The 32-bit
+// loop vectorizes, the 64-bit one is a scalar 64 x 64 bit multiply (mul/mulx) per value.
+inline void fastrange ( const std::uint32_t * first, std::size_t count, std::uint32_t n, std::uint32_t * out ) NOEXCEPT {
+    for ( std::size_t i = 0; i < count; ++i ) {
+        out [ i ] = fastrange ( first [ i ], n );
+    }
+}
+inline void fastrange ( const std::uint64_t * first, std::size_t count, std::uint64_t n, std::uint64_t * out ) NOEXCEPT {
+    for ( std::size_t i = 0; i < count; ++i ) {
+        out [ i ] = fastrange ( first [ i ], n );
+    }
+}
+
+
+// fastrange for a fixed n, f.e. the number of shards, a power of 2 is reduced by a shift.
+template<typename UIntType>
+class prepared_range {
+
+    static_assert ( std::is_same<UIntType, std::uint32_t>::value or std::is_same<UIntType, std::uint64_t>::value, "only 32- and 64-bit ranges are allowed." );
+
+    static constexpr int digits = std::numeric_limits<UIntType>::digits;
+
+    public:
+
+    using result_type = UIntType;
+
+    explicit prepared_range ( result_type n_ ) NOEXCEPT :
+        n ( n_ ) {
+        if ( n_ and not ( n_ & ( n_ - 1 ) ) ) {
+            shift = digits - ( digits - 1 - static_cast<int> ( detail::leading_zeros<result_type> ( n_ ) ) );
+        }
+    }
+
+    [[ nodiscard ]] result_type operator ( ) ( result_type x ) const NOEXCEPT {
+        if ( shift ) {
+            return shift == digits ? 0 : x >> shift;
+        }
+        return fastrange ( x, n );
+    }
+
+    void operator ( ) ( const result_type * first, std::size_t count, result_type * out ) const NOEXCEPT {
+        if ( shift ) {
+            for ( std::size_t i = 0; i < count; ++i ) {
+                out [ i ] = shift == digits ? 0 : first [ i ] >> shift;
+            }
+        }
+        else {
+            fastrange ( first, count, n, out );
+        }
+    }
+
+    [[ nodiscard ]] result_type size ( ) const NOEXCEPT {
+        return n;
+    }
+
+    private:
+
+    result_type n;
+    int shift = 0;
+};
+} // namespace ext
+
+
+// macro cleanup
+
+#undef NOEXCEPT
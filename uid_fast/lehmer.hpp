@@ -49,25 +49,25 @@ class mcg128 {
     static constexpr result_type min ( ) { return result_type ( 0 ); }
     static constexpr result_type max ( ) { return ~result_type ( 0 ); }
 
-    mcg128 ( stype state = stype ( 0x9f57c403d06c42fcUL ) )
+    constexpr mcg128 ( stype state = stype ( 0x9f57c403d06c42fcUL ) )
         : state_ ( state | 1 ) {
         // Nothing (else) to do.
     }
 
-    void advance ( ) {
+    constexpr void advance ( ) {
         state_ *= MCG_MULT;
     }
 
-    result_type operator()( ) {
+    constexpr result_type operator()( ) {
         advance ( );
         return result_type ( state_ >> ( STYPE_BITS - RTYPE_BITS ) );
     }
 
-    bool operator==( const mcg128& rhs ) {
+    constexpr bool operator==( const mcg128& rhs ) {
         return ( state_ == rhs.state_ );
     }
 
-    bool operator!=( const mcg128& rhs ) {
+    constexpr bool operator!=( const mcg128& rhs ) {
         return !operator==( rhs );
     }
 
@@ -92,25 +92,25 @@ class mcg128_fast {
     static constexpr result_type min ( ) { return result_type ( 0 ); }
     static constexpr result_type max ( ) { return ~result_type ( 0 ); }
 
-    mcg128_fast ( stype state = stype ( 0x9f57c403d06c42fcUL ) )
+    constexpr mcg128_fast ( stype state = stype ( 0x9f57c403d06c42fcUL ) )
         : state_ ( state | 1 ) {
         // Nothing (else) to do.
     }
 
-    void advance ( ) {
+    constexpr void advance ( ) {
         state_ *= MCG_MULT;
     }
 
-    result_type operator()( ) {
+    constexpr result_type operator()( ) {
         advance ( );
         return result_type ( state_ >> ( STYPE_BITS - RTYPE_BITS ) );
     }
 
-    bool operator==( const mcg128_fast& rhs ) {
+    constexpr bool operator==( const mcg128_fast& rhs ) {
         return ( state_ == rhs.state_ );
     }
 
-    bool operator!=( const mcg128_fast& rhs ) {
+    constexpr bool operator!=( const mcg128_fast& rhs ) {
         return !operator==( rhs );
     }
 
@@ -0,0 +1,181 @@
+
+// MIT License
+//
+// Copyright (c) 2018 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <numeric>
+#include <vector>
+
+#include "uniform_int_distribution_fast.hpp"
+#include "splitmix.hpp"
+
+#if defined ( _WIN32 ) && ! ( defined ( __clang__ ) || defined ( __GNUC__ ) ) // MSVC and not clang or gcc on windows.
+    #include <xmmintrin.h>
+    #define GNU 0
+    #define MSVC 1
+#else
+    #define GNU 1
+    #define MSVC 0
+#endif
+
+#if _HAS_EXCEPTIONS == 0
+    #define NOEXCEPT
+#else
+    #define NOEXCEPT noexcept
+#endif
+
+
+namespace ext {
+
+namespace detail {
+
+inline void prefetch ( const void * p ) NOEXCEPT {
+    #if GNU
+    __builtin_prefetch ( p, 0, 3 );
+    #else
+    _mm_prefetch ( static_cast<const char *> ( p ), _MM_HINT_T0 );
+    #endif
+}
+} // namespace detail
+
+
+// Draws uniform indices in [ 0, n ) into a table at base, with elements of stride bytes, a
+// distance D ahead of their use. Every index is prefetched as it enters a FIFO of D indices,
+// next ( ) returns the oldest one, whose cache line is then (ideally) in flight or has arrived,
+// such that a random probe overlaps its miss latency with the draws (and the work) of the D
+// probes before it. The sequence of indices is that of uniform_int_distribution_fast.
+template<typename Gen, typename IndexType = std::size_t, std::size_t MaxDistance = 64>
+class lookahead_index {
+
+    static_assert ( MaxDistance > 0, "the maximum distance should at least be 1." );
+
+    public:
+
+    using result_type = IndexType;
+    using distribution_type = uniform_int_distribution_fast<result_type>;
+
+    static constexpr std::size_t max_distance = MaxDistance;
+
+    explicit lookahead_index ( Gen & gen_, result_type n_, const void * base_, std::size_t stride_, std::size_t distance_ = 16 ) NOEXCEPT :
+        gen ( gen_ ),
+        distribution ( 0, result_type ( n_ - 1 ) ),
+        base ( static_cast<const unsigned char *> ( base_ ) ),
+        stride ( stride_ ) {
+        assert ( n_ > 0 );
+        distance ( distance_ );
+    }
+
+    [[ nodiscard ]] result_type next ( ) NOEXCEPT {
+        const result_type i = queue [ head ];
+        queue [ head ] = draw ( );
+        if ( ++head == size ) {
+            head = 0;
+        }
+        return i;
+    }
+
+    [[ nodiscard ]] result_type operator ( ) ( ) NOEXCEPT {
+        return next ( );
+    }
+
+    // Sets the look-ahead distance D, in [ 1, MaxDistance ], the indices pending beyond D (if the
+    // distance shrinks) are discarded, the others are returned in order.
+    void distance ( std::size_t d ) NOEXCEPT {
+        assert ( d > 0 );
+        d = std::min ( std::max ( d, std::size_t { 1 } ), max_distance );
+        std::rotate ( queue.begin ( ), queue.begin ( ) + head, queue.begin ( ) + size );
+        for ( std::size_t i = size; i < d; ++i ) {
+            queue [ i ] = draw ( );
+        }
+        size = d;
+        head = 0;
+    }
+
+    [[ nodiscard ]] std::size_t distance ( ) const NOEXCEPT {
+        return size;
+    }
+
+    [[ nodiscard ]] Gen & generator ( ) const NOEXCEPT {
+        return gen;
+    }
+
+    private:
+
+    [[ nodiscard ]] result_type draw ( ) NOEXCEPT {
+        const result_type i = distribution ( gen );
+        detail::prefetch ( base + static_cast<std::size_t> ( i ) * stride );
+        return i;
+    }
+
+    std::array<result_type, max_distance> queue;
+    std::size_t head = 0, size = 0;
+    Gen & gen;
+    distribution_type distribution;
+    const unsigned char * base;
+    std::size_t stride;
+};
+
+
+// Returns the latency (in ns) of a load missing the caches, measured by chasing pointers
+// through a random cyclic permutation (Sattolo) of bytes (by default 256MiB, larger than any
+// last level cache) of slots, every load depends on the previous one.
+inline double measure_miss_latency ( std::size_t bytes = std::size_t { 1 } << 28, std::size_t loads = std::size_t { 1 } << 22 ) {
+    std::vector<std::size_t> next ( bytes / sizeof ( std::size_t ) );
+    std::iota ( next.begin ( ), next.end ( ), std::size_t { 0 } );
+    splitmix64 gen ( 0x5E1EC7ED5A77010Full );
+    for ( std::size_t i = next.size ( ) - 1; i > 0; --i ) {
+        std::swap ( next [ i ], next [ bounded ( gen, i ) ] );
+    }
+    std::size_t p = 0;
+    const auto start = std::chrono::steady_clock::now ( );
+    for ( std::size_t i = 0; i < loads; ++i ) {
+        p = next [ p ];
+    }
+    const auto stop = std::chrono::steady_clock::now ( );
+    volatile std::size_t sink = p;
+    ( void ) sink;
+    return std::chrono::duration<double, std::nano> ( stop - start ).count ( ) / loads;
+}
+
+// Returns the (minimal) look-ahead distance covering a miss latency of latency_ns, if every
+// probe (the draw plus the work done on the probed element) takes step_ns. As misses overlap,
+// larger distances (up to MaxDistance) often still pay off.
+[[ nodiscard ]] inline std::size_t lookahead_distance ( double latency_ns, double step_ns ) NOEXCEPT {
+    return static_cast<std::size_t> ( std::max ( 1.0, std::ceil ( latency_ns / std::max ( step_ns, 0.1 ) ) ) );
+}
+} // namespace ext
+
+
+// macro cleanup
+
+#undef GNU
+#undef MSVC
+#undef NOEXCEPT
@@ -23,104 +23,261 @@
 
 #define _HAS_EXCEPTIONS 0
 
-#include <cassert>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <cstdlib>
 
-#include <array>
-#include <fstream>
+#include <algorithm>
+#include <charconv>
 #include <iostream>
-#include <iterator>
-#include <list>
-#include <map>
-#include <random>
 #include <string>
-#include <type_traits>
+#include <string_view>
 #include <vector>
 
-#include "splitmix.hpp"
-#if defined ( __GNUC__ ) || defined ( __clang__ )
-// #include "lehmer.hpp"
-#endif
-
-#include "uniform_int_distribution_fast.hpp"
+#include "bucket_test.hpp"
+#include "checks.hpp"
 #include "plf_nanotimer.h"
 #include "statistics.hpp"
+#include "uniformity_suite.hpp"
+
 
-#if UINTPTR_MAX == 0xFFFF'FFFF
-#define M32 1
-#define M64 0
-#elif UINTPTR_MAX == 0xFFFF'FFFF'FFFF'FFFF
-#define M32 0
-#define M64 1
-#else
-#error funny pointers detected
-#endif
-
-#if M32
-using generator = splitmix32;
-#else
-using generator = splitmix64;
-#endif
-using range_t = typename generator::result_type;
-
-
-int main ( ) {
-
-    constexpr range_t ts = 200'000;
-    constexpr std::size_t is = std::size_t { 1 } << 31;
-
-    std::uniform_int_distribution<range_t> sdis ( 0, ts - 1 );
-    ext::uniform_int_distribution_fast<range_t> fdis ( 0, ts - 1 );
-
-    {
-        generator rng ( 123 );
-        std::vector<range_t> freq ( ts, 0 );
-        plf::nanotimer t;
-        t.start ( );
-        for ( std::size_t k = 0; k < is; ++k ) {
-            ++freq [ static_cast<std::size_t> ( sdis ( rng ) ) ];
-        }
-        double et = t.get_elapsed_ms ( );
-        const auto [ min, max, mean, variance, sample_sd, population_sd ] = sf::stats ( freq.data ( ), freq.size ( ) );
-        std::cout << sample_sd << " " << et << std::endl;
+// Parses an unsigned integer, or a power of 2 as 2^k.
+[[ nodiscard ]] bool parse ( std::string_view s, std::uint64_t & value ) noexcept {
+    const bool power = s.size ( ) > 2 and s.substr ( 0, 2 ) == "2^";
+    if ( power ) {
+        s.remove_prefix ( 2 );
     }
-    {
-        generator rng ( 123 );
-        std::vector<range_t> freq ( ts, 0 );
-        plf::nanotimer t;
-        t.start ( );
-        for ( std::size_t k = 0; k < is; ++k ) {
-            ++freq [ static_cast< std::size_t > ( fdis ( rng ) ) ];
-        }
-        double et = t.get_elapsed_ms ( );
-        const auto [ min, max, mean, variance, sample_sd, population_sd ] = sf::stats ( freq.data ( ), freq.size ( ) );
-        std::cout << sample_sd << " " << et << std::endl;
+    std::uint64_t v = 0;
+    const auto [ p, ec ] = std::from_chars ( s.data ( ), s.data ( ) + s.size ( ), v );
+    if ( ec != std::errc { } or p != s.data ( ) + s.size ( ) or ( power and v > 63 ) ) {
+        return false;
     }
-    {
-        generator rng ( 123 );
-        std::vector<range_t> freq ( ts, 0 );
-        plf::nanotimer t;
-        t.start ( );
-        for ( std::size_t k = 0; k < is; ++k ) {
-            ++freq [ static_cast< std::size_t > ( sdis ( rng ) ) ];
-        }
-        double et = t.get_elapsed_ms ( );
-        const auto [ min, max, mean, variance, sample_sd, population_sd ] = sf::stats ( freq.data ( ), freq.size ( ) );
-        std::cout << sample_sd << " " << et << std::endl;
+    value = power ? std::uint64_t { 1 } << v : v;
+    return true;
+}
+
+void usage ( ) {
+    std::cout << "usage: uid_fast [--range n] [--draws n] [--threads n] [--distribution name] [--seed n] [--chunk n] [--partitioned]\n"
+                 "               [--cells 8|16] [--histogram-file path] [--suite] [--latency] [--check component]\n"
+                 "    n is an unsigned integer, or a power of 2, as in 2^31.\n"
+                 "    name is std, fast, bounded or an algorithm policy (f.e. lemire, canon, fixed<>).\n"
+                 "    --partitioned counts in cache-sized partitions, for ranges beyond the caches.\n"
+                 "    --cells counts (partitioned) in 8- or 16-bit cells, memory mapped (from path), for at most\n"
+                 "      64 resp. 16384 draws per bucket.\n"
+                 "    --suite runs the uniformity test suite, draws draws per width and range, name can be all.\n"
+                 "    --latency records the cycles of every draw, reports percentiles.\n"
+                 "    --check checks the range and uniformity of the draws of a component of the library, or all.\n";
+}
+
+// Runs the uniformity test suite over the distribution (or all of them) at all widths.
+int run_suite ( const bt::options & o ) {
+    std::vector<std::string_view> distributions;
+    if ( "all" == o.distribution ) {
+        for ( const auto & k : bt::kernel_table<std::uint64_t> ( ) ) {
+            distributions.push_back ( k.first );
+        }
+    }
+    else if ( bt::find_kernel ( o.distribution ).fill ) {
+        distributions.push_back ( o.distribution );
+    }
+    if ( distributions.empty ( ) or not o.draws or not o.chunk or not o.threads ) {
+        usage ( );
+        return EXIT_FAILURE;
+    }
+    std::cout << "draws " << o.draws << " per test, threads " << o.threads << ", p-values (suspect below " << bt::suite_alpha << ")\n";
+    bt::report_header ( std::cout );
+    int suspects = 0;
+    for ( const std::string_view name : distributions ) {
+        for ( const int width : { 16, 32, 64 } ) {
+            for ( const std::uint64_t range : bt::suite_ranges ( width ) ) {
+                bt::suite_result r = bt::test ( o, bt::find_kernel ( name, width ), width, range );
+                r.distribution = name;
+                bt::report ( std::cout, r );
+                suspects += r.min_p ( ) < bt::suite_alpha;
+            }
+        }
+    }
+    std::cout << suspects << " suspect" << std::endl;
+    return suspects ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+
+int main ( int argc, char ** argv ) {
+
+    bt::options o;
+    bool suite = false, latency = false;
+    std::string_view check;
+
+    for ( int i = 1; i < argc; ++i ) {
+        const std::string_view arg = argv [ i ];
+        if ( arg == "--partitioned" ) {
+            o.partitioned = true;
+            continue;
+        }
+        if ( arg == "--suite" ) {
+            suite = true;
+            continue;
+        }
+        if ( arg == "--latency" ) {
+            latency = true;
+            continue;
+        }
+        if ( i + 1 == argc ) {
+            usage ( );
+            return EXIT_FAILURE;
+        }
+        const std::string_view val = argv [ ++i ];
+        std::uint64_t v = 0;
+        bool ok = true;
+        if ( arg == "--distribution" ) {
+            o.distribution = val;
+        }
+        else if ( arg == "--histogram-file" ) {
+            o.histogram_file = val;
+        }
+        else if ( arg == "--check" ) {
+            check = val;
+        }
+        else if ( ( ok = parse ( val, v ) ) ) {
+            if ( arg == "--range" ) {
+                o.range = v;
+            }
+            else if ( arg == "--draws" ) {
+                o.draws = v;
+            }
+            else if ( arg == "--threads" ) {
+                o.threads = static_cast<unsigned> ( v );
+            }
+            else if ( arg == "--seed" ) {
+                o.seed = v;
+            }
+            else if ( arg == "--chunk" ) {
+                o.chunk = v;
+            }
+            else if ( arg == "--cells" ) {
+                o.cell_bits = static_cast<unsigned> ( v );
+                o.partitioned = true;
+                ok = 8 == v or 16 == v;
+            }
+            else {
+                ok = false;
+            }
+        }
+        if ( not ok ) {
+            usage ( );
+            return EXIT_FAILURE;
+        }
     }
-    {
-        generator rng ( 123 );
-        std::vector<range_t> freq ( ts, 0 );
-        plf::nanotimer t;
-        t.start ( );
-        for ( std::size_t k = 0; k < is; ++k ) {
-            ++freq [ static_cast< std::size_t > ( fdis ( rng ) ) ];
-        }
-        double et = t.get_elapsed_ms ( );
-        const auto [ min, max, mean, variance, sample_sd, population_sd ] = sf::stats ( freq.data ( ), freq.size ( ) );
-        std::cout << sample_sd << " " << et << std::endl;
+
+    if ( suite ) {
+        return run_suite ( o );
+    }
+
+    if ( not check.empty ( ) ) {
+        const int failures = ck::run ( std::cout, check );
+        if ( failures < 0 ) {
+            usage ( );
+            return EXIT_FAILURE;
+        }
+        std::cout << failures << " failed" << std::endl;
+        return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+
+    const bt::kernel_type kernel = bt::find_kernel ( o.distribution );
+
+    if ( not kernel.count or not o.range or not o.draws or not o.chunk or not o.threads ) {
+        usage ( );
+        return EXIT_FAILURE;
+    }
+
+    // Narrow cells only save memory if (almost) no bucket wraps.
+    if ( 64 != o.cell_bits ) {
+        const std::uint64_t limit = 8 == o.cell_bits ? bt::mapped_histogram<std::uint8_t>::mean_limit : bt::mapped_histogram<std::uint16_t>::mean_limit;
+        if ( o.draws / o.range > limit ) {
+            std::cerr << "warning: " << o.draws / o.range << " draws per bucket, more than " << limit << ", the " << o.cell_bits << "-bit cells wrap (and their carries take 4 bytes per bucket)" << std::endl;
+        }
+    }
+
+    // The statistics are accumulated exactly, in parallel slices of the counts (mergeable), the
+    // checksum is FNV-1a over the counts, equal for any number of threads.
+    sf::accumulator summary;
+    std::uint64_t checksum = 0xCBF2'9CE4'8422'2325;
+    const auto summarize = [ & ] ( const bt::counter_type * counts, std::size_t n ) {
+        const unsigned threads = static_cast<unsigned> ( std::max<std::size_t> ( std::min<std::size_t> ( o.threads, n / ( std::size_t { 1 } << 16 ) ), 1 ) );
+        std::vector<sf::accumulator> slices ( threads );
+        bt::parallel ( threads, [ & ] ( unsigned t ) {
+            const std::size_t first = n * t / threads, last = n * ( t + 1 ) / threads;
+            slices [ t ] ( counts + first, last - first );
+        } );
+        for ( const sf::accumulator & slice : slices ) {
+            summary.merge ( slice );
+        }
+        for ( std::size_t i = 0; i < n; ++i ) {
+            checksum = ( checksum ^ counts [ i ] ) * 0x100'0000'01B3;
+        }
+    };
+
+    if ( latency ) {
+        sf::latency_histogram<> overhead; // the serialized reads of the counter.
+        for ( int i = 0; i < 1 << 16; ++i ) {
+            overhead.time ( [ ] ( ) { } );
+        }
+        const sf::latency_histogram<> h = bt::run_latency ( o, kernel );
+        std::cout << "distribution " << o.distribution << ", range " << o.range << ", draws " << h.count ( ) << ", threads " << o.threads << ", cycles per draw (overhead " << overhead.percentile ( 50 ) << " included)\n";
+        std::cout << "min " << h.min ( ) << ", mean " << h.mean ( );
+        for ( const double p : { 50.0, 90.0, 99.0, 99.9, 99.99 } ) {
+            std::cout << ", p" << p << ' ' << h.percentile ( p );
+        }
+        std::cout << ", max " << h.max ( ) << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    plf::nanotimer t;
+    t.start ( );
+    double et = 0.0;
+    std::size_t overflows = 0, carry_pages = 0;
+    if ( 8 == o.cell_bits or 16 == o.cell_bits ) {
+        const auto run_mapped = [ & ] ( auto counts ) {
+            et = t.get_elapsed_ms ( );
+            overflows = counts.overflows ( );
+            carry_pages = counts.carry_pages ( );
+            // The counts are summarized per block of 2^22 (32MiB), every block in parallel, by slices of 2^16.
+            constexpr std::size_t summary_block = std::size_t { 1 } << 22;
+            std::vector<bt::counter_type> block;
+            block.reserve ( summary_block );
+            counts.for_each ( [ & ] ( bt::counter_type c ) {
+                block.push_back ( c );
+                if ( block.size ( ) == summary_block ) {
+                    summarize ( block.data ( ), block.size ( ) );
+                    block.clear ( );
+                }
+            } );
+            summarize ( block.data ( ), block.size ( ) );
+        };
+        if ( 8 == o.cell_bits ) {
+            run_mapped ( bt::run_mapped<std::uint8_t> ( o, kernel ) );
+        }
+        else {
+            run_mapped ( bt::run_mapped<std::uint16_t> ( o, kernel ) );
+        }
+    }
+    else {
+        const std::vector<bt::counter_type> freq = bt::run ( o, kernel );
+        et = t.get_elapsed_ms ( );
+        summarize ( freq.data ( ), freq.size ( ) );
+    }
+
+    const auto [ min, max, mean, variance, sample_sd, population_sd ] = summary.result ( );
+    const double expected_sd = std::sqrt ( static_cast<double> ( o.draws ) / o.range * ( 1.0 - 1.0 / o.range ) );
+
+    std::cout << "distribution " << o.distribution << ", range " << o.range << ", draws " << o.draws << ", threads " << o.threads << ( o.partitioned ? ", partitioned" : "" ) << '\n';
+    if ( 64 != o.cell_bits ) {
+        std::cout << o.cell_bits << "-bit cells, " << overflows << " overflowing buckets, " << carry_pages << " pages of carries\n";
     }
+    std::cout << "min " << min << ", max " << max << ", mean " << mean << ", sample_sd " << sample_sd << " (expected " << expected_sd << ")\n";
+    std::cout << "checksum " << std::hex << checksum << std::dec << '\n';
+    std::cout << et << " ms, " << ( o.draws / et / 1'000.0 ) << " Mdraws/s" << std::endl;
 
     return EXIT_SUCCESS;
 }
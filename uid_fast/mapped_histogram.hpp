@@ -0,0 +1,205 @@
+
+// MIT License
+//
+// Copyright (c) 2018 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if __has_include ( <sys/mman.h> )
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <unistd.h>
+    #define HAVE_MMAP 1
+#else
+    #define HAVE_MMAP 0
+#endif
+
+
+namespace bt {
+
+// A histogram of 8- or 16-bit cells, in memory mapped from a file (or anonymous memory), the
+// cells wrap, their carries go to dense 32-bit carry cells, allocated by page (of 2^14 buckets,
+// 64KiB) on the first carry in the page. 2^32 buckets take 4GiB of 8-bit cells, instead of 32GiB
+// of 64-bit counters, as long as (almost) no bucket wraps, i.e. for some 64 (8-bit cells) or
+// 16384 (16-bit cells) draws per bucket at most, a quarter of the cell maximum, beyond, every
+// page of carries gets allocated (4 bytes more per bucket). Without mmap, the cells are on the
+// heap. Increments of buckets in the same page should not race, those of different pages may.
+template<typename Cell, typename Count = std::uint64_t>
+class mapped_histogram {
+
+    static_assert ( std::is_same<Cell, std::uint8_t>::value or std::is_same<Cell, std::uint16_t>::value, "the cells should be 8 or 16 bits wide." );
+
+    public:
+
+    using cell_type = Cell;
+    using count_type = Count;
+    using carry_type = std::uint32_t;
+
+    static constexpr count_type carry = count_type { std::numeric_limits<cell_type>::max ( ) } + 1;
+    static constexpr int page_bits = 14;
+    static constexpr std::size_t page_size = std::size_t { 1 } << page_bits;
+
+    // The largest mean count per bucket for which the cells (almost) never wrap.
+    static constexpr count_type mean_limit = carry / 4;
+
+    // A histogram of size buckets, in the file at path (created or truncated, and kept), or
+    // in anonymous memory if path is empty.
+    explicit mapped_histogram ( std::size_t size_, const std::string & path = { } ) :
+        size ( size_ ),
+        pages ( ( size_ + page_size - 1 ) >> page_bits ) {
+        #if HAVE_MMAP
+        const std::size_t bytes = std::max ( size * sizeof ( cell_type ), std::size_t { 1 } );
+        int flags = MAP_SHARED;
+        if ( path.empty ( ) ) {
+            flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE;
+        }
+        else {
+            if ( ( file = ::open ( path.c_str ( ), O_RDWR | O_CREAT | O_TRUNC, 0644 ) ) < 0 ) {
+                throw std::system_error ( errno, std::generic_category ( ), path );
+            }
+            if ( ::ftruncate ( file, static_cast<off_t> ( bytes ) ) ) { // sparse, reads as zeros.
+                const int error = errno;
+                ::close ( file );
+                throw std::system_error ( error, std::generic_category ( ), path );
+            }
+        }
+        void * const p = ::mmap ( nullptr, bytes, PROT_READ | PROT_WRITE, flags, file, 0 );
+        if ( MAP_FAILED == p ) {
+            const int error = errno;
+            if ( file >= 0 ) {
+                ::close ( file );
+            }
+            throw std::system_error ( error, std::generic_category ( ), "mmap" );
+        }
+        cells = static_cast<cell_type *> ( p );
+        #else
+        ( void ) path;
+        heap.reset ( new cell_type [ size ] ( ) );
+        cells = heap.get ( );
+        #endif
+    }
+
+    mapped_histogram ( const mapped_histogram & ) = delete;
+    mapped_histogram & operator = ( const mapped_histogram & ) = delete;
+
+    mapped_histogram ( mapped_histogram && other_ ) noexcept :
+        cells ( std::exchange ( other_.cells, nullptr ) ),
+        size ( std::exchange ( other_.size, 0 ) ),
+        pages ( std::move ( other_.pages ) ) {
+        #if HAVE_MMAP
+        file = std::exchange ( other_.file, -1 );
+        #else
+        heap = std::move ( other_.heap );
+        #endif
+    }
+
+    ~mapped_histogram ( ) noexcept {
+        #if HAVE_MMAP
+        if ( cells ) {
+            ::munmap ( cells, std::max ( size * sizeof ( cell_type ), std::size_t { 1 } ) );
+        }
+        if ( file >= 0 ) {
+            ::close ( file );
+        }
+        #endif
+    }
+
+    void increment ( std::size_t i ) {
+        if ( not ++cells [ i ] ) {
+            std::unique_ptr<carry_type [ ]> & page = pages [ i >> page_bits ];
+            if ( not page ) {
+                page.reset ( new carry_type [ page_size ] ( ) );
+            }
+            ++page [ i & ( page_size - 1 ) ];
+        }
+    }
+
+    [[ nodiscard ]] count_type operator [ ] ( std::size_t i ) const {
+        const std::unique_ptr<carry_type [ ]> & page = pages [ i >> page_bits ];
+        return count_type { cells [ i ] } + ( page ? page [ i & ( page_size - 1 ) ] * carry : 0 );
+    }
+
+    [[ nodiscard ]] std::size_t buckets ( ) const noexcept {
+        return size;
+    }
+
+    // The number of buckets exceeding the cell width.
+    [[ nodiscard ]] std::size_t overflows ( ) const noexcept {
+        std::size_t n = 0;
+        for ( const std::unique_ptr<carry_type [ ]> & page : pages ) {
+            if ( page ) {
+                n += static_cast<std::size_t> ( std::count_if ( page.get ( ), page.get ( ) + page_size, [ ] ( carry_type c ) { return c; } ) );
+            }
+        }
+        return n;
+    }
+
+    // The number of pages of carries allocated.
+    [[ nodiscard ]] std::size_t carry_pages ( ) const noexcept {
+        return static_cast<std::size_t> ( std::count_if ( pages.begin ( ), pages.end ( ), [ ] ( const std::unique_ptr<carry_type [ ]> & page ) { return page != nullptr; } ) );
+    }
+
+    // Calls f ( count ) for every bucket, in order, the cells are read sequentially (and the
+    // kernel is told so), the carries are added in, page by page.
+    template<typename F>
+    void for_each ( F && f ) const {
+        #if HAVE_MMAP
+        ::madvise ( cells, size * sizeof ( cell_type ), MADV_SEQUENTIAL );
+        #endif
+        for ( std::size_t p = 0, i = 0; p < pages.size ( ); ++p ) {
+            const carry_type * const page = pages [ p ].get ( );
+            const std::size_t end = std::min ( size, i + page_size );
+            for ( std::size_t j = 0; i < end; ++i, ++j ) {
+                f ( count_type { cells [ i ] } + ( page ? page [ j ] * carry : 0 ) );
+            }
+        }
+    }
+
+    private:
+
+    cell_type * cells = nullptr;
+    std::size_t size;
+    std::vector<std::unique_ptr<carry_type [ ]>> pages;
+    #if HAVE_MMAP
+    int file = -1;
+    #else
+    std::unique_ptr<cell_type [ ]> heap;
+    #endif
+};
+} // namespace bt
+
+
+// macro cleanup
+
+#undef HAVE_MMAP
@@ -0,0 +1,188 @@
+
+// MIT License
+//
+// Copyright (c) 2018 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <string>
+#include <string_view>
+
+#include "uniform_int_distribution_fast.hpp"
+
+#if defined ( __SSSE3__ ) || defined ( __AVX__ )
+    #include <tmmintrin.h>
+    #define HAVE_SSSE3 1
+#else
+    #define HAVE_SSSE3 0
+#endif
+
+#if _HAS_EXCEPTIONS == 0
+    #define NOEXCEPT
+#else
+    #define NOEXCEPT noexcept
+#endif
+
+
+namespace ext {
+
+// Writes random strings (tokens, session IDs, test keys) over an alphabet of up to 256
+// characters. Several characters are taken from each 64-bit engine word, for an alphabet of
+// size A = 2^b, b bits per character, otherwise the k base-A digits of one draw over [ 0, A^k ),
+// A^k <= 2^64 (f.e. 10 base-62 digits). That draw is Lemire's floor ( w * A^k / 2^64 ), with a
+// single rejection check per word against the pre-computed threshold, its digits are the
+// integer parts of the fraction w / 2^64 multiplied by A, k times, one multiply per digit. The
+// digits are mapped onto the alphabet in bulk, with SSSE3 by a pshufb lookup (alphabets up to
+// 16 characters) or four pshufb lookups and masks (up to 64 characters).
+class random_string {
+
+    template<typename Gen>
+    using generator_reference = detail::bits_engine<Gen, std::uint64_t, ( Gen::max ( ) < std::numeric_limits<std::uint64_t>::max ( ) )>;
+
+    public:
+
+    explicit random_string ( std::string_view alphabet_ ) :
+        alphabet_size ( alphabet_.size ( ) ) {
+        assert ( alphabet_size and alphabet_size <= table.size ( ) );
+        for ( std::size_t i = 0; i < alphabet_size; ++i ) {
+            table [ i ] = alphabet_ [ i ];
+        }
+        if ( 1 == alphabet_size ) {
+            return;
+        }
+        if ( not ( alphabet_size & ( alphabet_size - 1 ) ) ) {
+            bits = 63 - static_cast<int> ( detail::leading_zeros<std::uint64_t> ( alphabet_size ) );
+            per_word = 64 / bits;
+            return;
+        }
+        range = 1;
+        while ( range <= std::numeric_limits<std::uint64_t>::max ( ) / alphabet_size ) {
+            range *= alphabet_size;
+            ++per_word;
+        }
+        threshold = detail::threshold ( range );
+    }
+
+    // Writes n characters to [ first, first + n ).
+    template<typename Gen>
+    void operator ( ) ( Gen & rng, char * first, std::size_t n ) const NOEXCEPT {
+        if ( 1 == alphabet_size ) {
+            std::fill_n ( first, n, table [ 0 ] );
+            return;
+        }
+        generator_reference<Gen> rng_ref ( rng );
+        unsigned char * const digits = reinterpret_cast<unsigned char *> ( first );
+        if ( bits ) {
+            const std::uint64_t mask = ( std::uint64_t { 1 } << bits ) - 1;
+            for ( std::size_t i = 0; i < n; ) {
+                std::uint64_t x = rng_ref ( );
+                for ( const std::size_t m = std::min ( n, i + per_word ); i < m; ++i, x >>= bits ) {
+                    digits [ i ] = static_cast<unsigned char> ( x & mask );
+                }
+            }
+        }
+        else {
+            const std::uint64_t a = alphabet_size;
+            for ( std::size_t i = 0; i < n; ) {
+                std::uint64_t w;
+                do {
+                    w = rng_ref ( );
+                } while ( w * range < threshold ); // the low half of w * A^k.
+                for ( const std::size_t m = std::min ( n, i + per_word ); i < m; ++i ) {
+                    digits [ i ] = static_cast<unsigned char> ( detail::wide_multiply<std::uint64_t> ( w, a, w ) );
+                }
+            }
+        }
+        translate ( digits, n );
+    }
+
+    template<typename Gen>
+    [[ nodiscard ]] std::string operator ( ) ( Gen & rng, std::size_t n ) const {
+        std::string s ( n, '\0' );
+        ( *this ) ( rng, s.data ( ), n );
+        return s;
+    }
+
+    [[ nodiscard ]] std::string_view alphabet ( ) const NOEXCEPT {
+        return { table.data ( ), alphabet_size };
+    }
+
+    // The number of characters taken from one engine word.
+    [[ nodiscard ]] int chars_per_word ( ) const NOEXCEPT {
+        return per_word;
+    }
+
+    private:
+
+    // Maps the digits in [ digits, digits + n ) onto the alphabet, in place.
+    void translate ( unsigned char * digits, std::size_t n ) const NOEXCEPT {
+        std::size_t i = 0;
+        #if HAVE_SSSE3
+        if ( alphabet_size <= 16 ) {
+            const __m128i t = _mm_loadu_si128 ( reinterpret_cast<const __m128i *> ( table.data ( ) ) );
+            for ( ; i + 16 <= n; i += 16 ) {
+                __m128i * const p = reinterpret_cast<__m128i *> ( digits + i );
+                _mm_storeu_si128 ( p, _mm_shuffle_epi8 ( t, _mm_loadu_si128 ( p ) ) );
+            }
+        }
+        else if ( alphabet_size <= 64 ) {
+            // pshufb looks at the low 4 bits of a digit (bits 4 and 5 select the table quarter).
+            __m128i t [ 4 ];
+            for ( int j = 0; j < 4; ++j ) {
+                t [ j ] = _mm_loadu_si128 ( reinterpret_cast<const __m128i *> ( table.data ( ) + 16 * j ) );
+            }
+            const __m128i quarter = _mm_set1_epi8 ( 0x30 );
+            for ( ; i + 16 <= n; i += 16 ) {
+                __m128i * const p = reinterpret_cast<__m128i *> ( digits + i );
+                const __m128i d = _mm_loadu_si128 ( p ), q = _mm_and_si128 ( d, quarter );
+                __m128i r = _mm_setzero_si128 ( );
+                for ( int j = 0; j < 4; ++j ) {
+                    const __m128i s = _mm_cmpeq_epi8 ( q, _mm_set1_epi8 ( static_cast<char> ( 16 * j ) ) );
+                    r = _mm_or_si128 ( r, _mm_and_si128 ( s, _mm_shuffle_epi8 ( t [ j ], d ) ) );
+                }
+                _mm_storeu_si128 ( p, r );
+            }
+        }
+        #endif
+        for ( ; i < n; ++i ) {
+            digits [ i ] = static_cast<unsigned char> ( table [ digits [ i ] ] );
+        }
+    }
+
+    std::array<char, 256> table { };
+    std::size_t alphabet_size;
+    std::uint64_t range = 0, threshold = 0; // A^k and 2^64 % A^k, if A is not a power of 2.
+    int bits = 0, per_word = 0;
+};
+} // namespace ext
+
+
+// macro cleanup
+
+#undef HAVE_SSSE3
+#undef NOEXCEPT
@@ -42,7 +42,7 @@
 namespace splitmix_detail {
 
 template <typename IntRep>
-IntRep fast_exp(IntRep x, IntRep power)
+constexpr IntRep fast_exp(IntRep x, IntRep power)
 {
     IntRep result = IntRep(1);
     IntRep multiplier = x;
@@ -56,7 +56,7 @@ IntRep fast_exp(IntRep x, IntRep power)
 }
 
 template <typename IntRep>
-inline IntRep modular_inverse(IntRep x)
+inline constexpr IntRep modular_inverse(IntRep x)
 {
     return fast_exp(x, IntRep(-1));
 }
@@ -67,7 +67,7 @@ inline IntRep modular_inverse(IntRep x)
 // use a popcount intrinsic if you can since most modern CPUs have one.
 
 template <typename IntRep>
-inline unsigned int pop_count(IntRep x) {
+inline constexpr unsigned int pop_count(IntRep x) {
     unsigned int count = 0;
     while (x) {
         ++count;
@@ -79,7 +79,7 @@ inline unsigned int pop_count(IntRep x) {
 #else
 
 template <typename IntRep>
-inline IntRep pop_count(IntRep x) {
+inline constexpr IntRep pop_count(IntRep x) {
     if (sizeof(int) <= sizeof(IntRep))
         return __builtin_popcount(x);
     else if (sizeof(long) <= sizeof(IntRep))
@@ -105,7 +105,7 @@ protected:
     uint64_t seed_;
     uint64_t gamma_;
 
-    static uint64_t mix_gamma(uint64_t x) {
+    static constexpr uint64_t mix_gamma(uint64_t x) {
         x ^= x >> p;
         x *= m1;
         x ^= x >> q;
@@ -125,62 +125,62 @@ protected:
         return x;
     }
 
-    void advance() {
+    constexpr void advance() {
         seed_ += gamma_;
     }
 
-    uint64_t next_seed() {
+    constexpr uint64_t next_seed() {
         uint64_t result = seed_;
         advance();
         return result;
     }
 
 public:
-    splitmix64_base(uint64_t seed  = 0xbad0ff1ced15ea5e,
+    constexpr splitmix64_base(uint64_t seed  = 0xbad0ff1ced15ea5e,
                     uint64_t gamma = 0x9e3779b97f4a7c15)
         : seed_(seed), gamma_(gamma | 1)
     {
         // Nothing (else) to do.
     }
 
-    result_type operator()() { // degski: changed return type to result_type.
+    constexpr result_type operator()() { // degski: changed return type to result_type.
         return mix64(next_seed());
     }
 
     template<typename It>
-    void generate (It it, const It end) { // degski: added this function.
+    constexpr void generate (It it, const It end) { // degski: added this function.
         while (it != end) {
             *it++ = mix64(next_seed());
         }
     }
 
-    void seed ( const result_type s_ ) noexcept { // degski: added this function.
+    constexpr void seed ( const result_type s_ ) noexcept { // degski: added this function.
         seed_ = s_;
     }
 
-    void advance(uint64_t delta) {
+    constexpr void advance(uint64_t delta) {
         seed_ += delta * gamma_;
     }
 
-    void backstep(uint64_t delta) {
+    constexpr void backstep(uint64_t delta) {
         advance(-delta);
     }
 
-    bool wrapped() {
+    constexpr bool wrapped() {
         return seed_ == 0;
     }
 
-    uint64_t operator-(const splitmix64_base& other) {
+    constexpr uint64_t operator-(const splitmix64_base& other) {
         return (seed_ - other.seed_) * modular_inverse(other.gamma_);
     }
 
-    splitmix64_base split() {
+    constexpr splitmix64_base split() {
         uint64_t new_seed  = operator()();
         uint64_t new_gamma = mix_gamma(next_seed());
         return { new_seed, new_gamma };
     }
 
-    bool operator==(const splitmix64_base& rhs) {
+    constexpr bool operator==(const splitmix64_base& rhs) {
         return (seed_ == rhs.seed_) && (gamma_ == rhs.gamma_);
     }
 };
@@ -195,7 +195,7 @@ public:
 
     using splitmix::splitmix;
 
-    result_type operator()() {
+    constexpr result_type operator()() {
         uint64_t seed = splitmix::next_seed();
         seed ^= seed >> v;
         seed *= m5;
@@ -204,7 +204,7 @@ public:
         return result_type(seed >> 32);
     }
 
-    splitmix32_base split() {
+    constexpr splitmix32_base split() {
         return splitmix::split();
     }
 };
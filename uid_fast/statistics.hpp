@@ -26,27 +26,491 @@
 #define _USE_MATH_DEFINES
 #include <cmath>
 #include <cstddef>
+#include <cstdint>
 
+#include <algorithm>
 #include <limits>
 #include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "uniform_int_distribution_fast.hpp"
+
+#if defined ( _WIN32 ) && ! ( defined ( __clang__ ) || defined ( __GNUC__ ) ) // MSVC and not clang or gcc on windows.
+    #include <intrin.h>
+    #define GNU 0
+    #define MSVC 1
+#else
+    #define GNU 1
+    #define MSVC 0
+#endif
+
+#if defined ( __x86_64__ ) || defined ( __i386__ ) || defined ( _M_X64 ) || defined ( _M_IX86 )
+    #if GNU
+        #include <x86intrin.h>
+    #endif
+    #define HAVE_RDTSC 1
+#else
+    #include <chrono>
+    #define HAVE_RDTSC 0
+#endif
 
 
 namespace sf {
 
 // Wellford's method: https://www.johndcook.com/blog/standard_deviation/
-// returns min, max, mean, variance, sample_sd, population_sd.
-template<typename T>
-std::tuple<long double, long double, long double, long double, long double, long double> stats ( T * data, std::size_t n ) noexcept {
-    long double min = ( long double ) std::numeric_limits<T>::max ( ), max = ( long double ) std::numeric_limits<T>::min ( );
-    long double avg = 0.0, var = 0.0;
-    for ( std::size_t i = 0; i < n; i++ ) {
-        const long double d = ( long double ) data [ i ];
+// one value at a time, result ( ) returns min, max, mean, variance, sample_sd, population_sd.
+class welford {
+
+    public:
+
+    template<typename T>
+    void operator ( ) ( T x ) noexcept {
+        const long double d = ( long double ) x;
         if ( d < min ) min = d;
         if ( d > max ) max = d;
         const long double t = d - avg;
-        avg += t / ( i + 1 );
+        avg += t / ++n;
         var += t * ( d - avg );
     }
-    return { min, max, avg, var, std::sqrt ( var / ( n - 1 ) ), std::sqrt ( var / n ) };
+
+    [[ nodiscard ]] std::tuple<long double, long double, long double, long double, long double, long double> result ( ) const noexcept {
+        return { min, max, avg, var, std::sqrt ( var / ( n - 1 ) ), std::sqrt ( var / n ) };
+    }
+
+    private:
+
+    long double min = std::numeric_limits<long double>::infinity ( ), max = -std::numeric_limits<long double>::infinity ( );
+    long double avg = 0.0, var = 0.0;
+    std::size_t n = 0;
+};
+
+namespace detail {
+
+// An unsigned integer of N 64-bit words, little endian, as far as the accumulator needs one (the
+// arithmetic is modulo 2^( 64 N )).
+template<std::size_t N>
+struct wide_uint {
+
+    wide_uint & operator += ( const wide_uint & o ) noexcept {
+        std::uint64_t carry = 0;
+        for ( std::size_t i = 0; i < N; ++i ) {
+            const std::uint64_t w = word [ i ] + carry;
+            carry = w < carry;
+            word [ i ] = w + o.word [ i ];
+            carry += word [ i ] < w;
+        }
+        return *this;
+    }
+    wide_uint & operator -= ( const wide_uint & o ) noexcept {
+        std::uint64_t borrow = 0;
+        for ( std::size_t i = 0; i < N; ++i ) {
+            const std::uint64_t w = word [ i ] - borrow;
+            borrow = w > word [ i ];
+            borrow += w < o.word [ i ];
+            word [ i ] = w - o.word [ i ];
+        }
+        return *this;
+    }
+
+    // Returns this * b (modulo 2^( 64 N )).
+    [[ nodiscard ]] wide_uint operator * ( std::uint64_t b ) const noexcept {
+        wide_uint r { };
+        std::uint64_t carry = 0;
+        for ( std::size_t i = 0; i < N; ++i ) {
+            std::uint64_t hi = 0;
+            const std::uint64_t lo = multiply ( word [ i ], b, hi );
+            r.word [ i ] = lo + carry;
+            carry = hi + ( r.word [ i ] < lo );
+        }
+        return r;
+    }
+
+    // Returns this / d and sets r to this % d, by long division.
+    [[ nodiscard ]] wide_uint divide ( std::uint64_t d, std::uint64_t & r ) const noexcept {
+        wide_uint q { };
+        r = 0;
+        for ( std::size_t i = 64 * N; i-- > 0; ) {
+            const bool top = r >> 63;
+            r = ( r << 1 ) | ( ( word [ i / 64 ] >> ( i % 64 ) ) & 1 );
+            if ( top or r >= d ) {
+                r -= d;
+                q.word [ i / 64 ] |= std::uint64_t { 1 } << ( i % 64 );
+            }
+        }
+        return q;
+    }
+
+    [[ nodiscard ]] long double value ( ) const noexcept {
+        long double v = 0.0;
+        for ( std::size_t i = N; i-- > 0; ) {
+            v = v * 18'446'744'073'709'551'616.0L + ( long double ) word [ i ];
+        }
+        return v;
+    }
+
+    // Returns the low half of a * b, sets hi to the high half.
+    [[ nodiscard ]] static std::uint64_t multiply ( std::uint64_t a, std::uint64_t b, std::uint64_t & hi ) noexcept {
+        const std::uint64_t a_lo = a & 0xFFFF'FFFF, a_hi = a >> 32, b_lo = b & 0xFFFF'FFFF, b_hi = b >> 32;
+        const std::uint64_t ll = a_lo * b_lo, lh = a_lo * b_hi, hl = a_hi * b_lo;
+        const std::uint64_t mid = ( ll >> 32 ) + ( lh & 0xFFFF'FFFF ) + ( hl & 0xFFFF'FFFF );
+        hi = a_hi * b_hi + ( lh >> 32 ) + ( hl >> 32 ) + ( mid >> 32 );
+        return ( mid << 32 ) | ( ll & 0xFFFF'FFFF );
+    }
+
+    std::uint64_t word [ N ];
+};
+
+template<std::size_t N, std::size_t M>
+[[ nodiscard ]] wide_uint<N> widen ( const wide_uint<M> & v ) noexcept {
+    wide_uint<N> r { };
+    for ( std::size_t i = 0; i < std::min ( N, M ); ++i ) {
+        r.word [ i ] = v.word [ i ];
+    }
+    return r;
 }
+} // namespace detail
+
+// Sums of unsigned integers (counts) and of their squares, exact (128- and 192-bit), with the minimum
+// and the maximum. Blocks of values below 2^32 are summed in 64-bit lanes (the squares split in
+// their high and low halves), without carries or divisions, a loop the compiler vectorizes,
+// larger values go one at a time. Accumulators of parts of the data merge exactly (the sums
+// add up, Chan et al.'s pairwise update of mean and variance is then implied, without loss).
+// result ( ) returns min, max, mean, variance, sample_sd, population_sd (as welford does).
+class accumulator {
+
+    static constexpr std::size_t block = 4'096;
+
+    using sum_type = detail::wide_uint<2>;
+    using square_type = detail::wide_uint<3>;
+
+    public:
+
+    template<typename T>
+    void operator ( ) ( T x ) noexcept {
+        static_assert ( std::is_integral<T>::value and std::is_unsigned<T>::value, "the accumulator sums unsigned integers." );
+        const std::uint64_t v = x;
+        square_type square { };
+        square.word [ 0 ] = square_type::multiply ( v, v, square.word [ 1 ] );
+        add ( sum_type { { v, 0 } }, square, v, v, 1 );
+    }
+
+    // Accumulates [ data, data + n ).
+    template<typename T>
+    void operator ( ) ( const T * data, std::size_t n ) noexcept {
+        static_assert ( std::is_integral<T>::value and std::is_unsigned<T>::value, "the accumulator sums unsigned integers." );
+        for ( ; n; ) {
+            const std::size_t m = std::min ( n, block );
+            std::uint64_t sum = 0, squares_lo = 0, squares_hi = 0, wide = 0;
+            T min_ = std::numeric_limits<T>::max ( ), max_ = 0;
+            for ( std::size_t i = 0; i < m; ++i ) {
+                const std::uint64_t v = data [ i ], square = v * v;
+                sum += v;
+                squares_lo += square & 0xFFFF'FFFF;
+                squares_hi += square >> 32;
+                wide |= v >> 32;
+                min_ = std::min ( min_, data [ i ] );
+                max_ = std::max ( max_, data [ i ] );
+            }
+            if ( wide ) {
+                for ( std::size_t i = 0; i < m; ++i ) {
+                    ( *this ) ( data [ i ] );
+                }
+            }
+            else {
+                square_type squares { { squares_hi << 32, squares_hi >> 32, 0 } };
+                squares += square_type { { squares_lo, 0, 0 } };
+                add ( sum_type { { sum, 0 } }, squares, min_, max_, m );
+            }
+            data += m;
+            n -= m;
+        }
+    }
+
+    void merge ( const accumulator & o ) noexcept {
+        if ( o.n ) {
+            add ( o.sum, o.squares, o.min, o.max, o.n );
+        }
+    }
+
+    [[ nodiscard ]] std::uint64_t count ( ) const noexcept {
+        return n;
+    }
+
+    [[ nodiscard ]] std::tuple<long double, long double, long double, long double, long double, long double> result ( ) const noexcept {
+        if ( not n ) {
+            return { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+        }
+        // With sum = q * n + r, the sum of the squared deviations from q, squares - 2 q sum + q^2 n,
+        // is exact (and small), the deviation of the mean from q, r / n, corrects it.
+        std::uint64_t r = 0;
+        const std::uint64_t q = sum.divide ( n, r ).word [ 0 ]; // the mean is at most max.
+        square_type deviations = squares;
+        deviations -= detail::widen<3> ( sum ) * q * 2;
+        deviations += detail::widen<3> ( sum_type { { q, 0 } } * n ) * q;
+        const long double mean = ( long double ) q + ( long double ) r / n;
+        const long double var = deviations.value ( ) - ( long double ) r * r / n;
+        return { ( long double ) min, ( long double ) max, mean, var, std::sqrt ( var / ( n - 1 ) ), std::sqrt ( var / n ) };
+    }
+
+    private:
+
+    void add ( const sum_type & sum_, const square_type & squares_, std::uint64_t min_, std::uint64_t max_, std::uint64_t n_ ) noexcept {
+        sum += sum_;
+        squares += squares_;
+        min = std::min ( min, min_ );
+        max = std::max ( max, max_ );
+        n += n_;
+    }
+
+    sum_type sum { };
+    square_type squares { };
+    std::uint64_t min = std::numeric_limits<std::uint64_t>::max ( ), max = 0, n = 0;
+};
+
+// returns min, max, mean, variance, sample_sd, population_sd, exact for unsigned integers.
+template<typename T>
+std::tuple<long double, long double, long double, long double, long double, long double> stats ( T * data, std::size_t n ) noexcept {
+    if constexpr ( std::is_integral<T>::value and std::is_unsigned<T>::value ) {
+        accumulator a;
+        a ( static_cast<const T *> ( data ), n );
+        return a.result ( );
+    }
+    else {
+        welford w;
+        for ( std::size_t i = 0; i < n; i++ ) {
+            w ( data [ i ] );
+        }
+        return w.result ( );
+    }
 }
+
+
+// Returns the regularized upper incomplete gamma function Q ( a, x ), by its series (for x <
+// a + 1) or its continued fraction (Lentz), as in Numerical Recipes 6.2.
+[[ nodiscard ]] inline double gamma_q ( double a, double x ) noexcept {
+    if ( x <= 0.0 ) {
+        return 1.0;
+    }
+    const double log_prefix = a * std::log ( x ) - x - std::lgamma ( a );
+    if ( x < a + 1.0 ) {
+        double term = 1.0 / a, sum = term;
+        for ( double n = a + 1.0; std::abs ( term ) > std::abs ( sum ) * 1e-15; n += 1.0 ) {
+            term *= x / n;
+            sum += term;
+        }
+        return std::max ( 0.0, 1.0 - sum * std::exp ( log_prefix ) );
+    }
+    const double tiny = std::numeric_limits<double>::min ( ) / std::numeric_limits<double>::epsilon ( );
+    double b = x + 1.0 - a, c = 1.0 / tiny, d = 1.0 / b, h = d;
+    for ( int i = 1; i < 100'000; ++i ) {
+        const double an = -i * ( i - a );
+        b += 2.0;
+        d = an * d + b;
+        if ( std::abs ( d ) < tiny ) d = tiny;
+        c = b + an / c;
+        if ( std::abs ( c ) < tiny ) c = tiny;
+        d = 1.0 / d;
+        const double delta = d * c;
+        h *= delta;
+        if ( std::abs ( delta - 1.0 ) < 1e-15 ) {
+            break;
+        }
+    }
+    return std::min ( 1.0, std::exp ( log_prefix ) * h );
+}
+
+// Returns the p-value of a chi-squared statistic with df degrees of freedom.
+[[ nodiscard ]] inline double chi_squared_p ( double chi_squared, double df ) noexcept {
+    return gamma_q ( 0.5 * df, 0.5 * chi_squared );
+}
+
+// Returns the p-value of a Kolmogorov-Smirnov statistic d over n samples, by the asymptotic
+// Kolmogorov distribution (with Stephens' correction).
+[[ nodiscard ]] inline double kolmogorov_smirnov_p ( double d, double n ) noexcept {
+    const double sqrt_n = std::sqrt ( n ), lambda = ( sqrt_n + 0.12 + 0.11 / sqrt_n ) * d;
+    if ( lambda < 0.2 ) {
+        return 1.0;
+    }
+    double sum = 0.0, sign = 1.0;
+    for ( int k = 1; k <= 100; ++k, sign = -sign ) {
+        const double term = sign * std::exp ( -2.0 * k * k * lambda * lambda );
+        sum += term;
+        if ( std::abs ( term ) < 1e-16 ) {
+            break;
+        }
+    }
+    return std::min ( 1.0, std::max ( 0.0, 2.0 * sum ) );
+}
+
+// Returns the (two-sided) p-value of a standard normal z-score.
+[[ nodiscard ]] inline double normal_p ( double z ) noexcept {
+    return std::erfc ( std::abs ( z ) / std::sqrt ( 2.0 ) );
+}
+
+
+// Returns the time stamp counter (cycles, at a constant rate), or nanoseconds if there is none.
+[[ nodiscard ]] inline std::uint64_t cycles ( ) noexcept {
+    #if HAVE_RDTSC
+    return __rdtsc ( );
+    #else
+    return static_cast<std::uint64_t> ( std::chrono::steady_clock::now ( ).time_since_epoch ( ).count ( ) );
+    #endif
+}
+
+// The time stamp counter, serialized (per the SDM), for timing short stretches of code,
+// cycles_start ( ) is read after the code before it has completed (lfence) and before the
+// timed code starts (lfence), cycles_stop ( ) after the timed code has completed (rdtscp) and
+// before the code after it starts (lfence). Without a counter, these are cycles ( ).
+[[ nodiscard ]] inline std::uint64_t cycles_start ( ) noexcept {
+    #if HAVE_RDTSC
+    _mm_lfence ( );
+    const std::uint64_t t = __rdtsc ( );
+    _mm_lfence ( );
+    return t;
+    #else
+    return cycles ( );
+    #endif
+}
+
+[[ nodiscard ]] inline std::uint64_t cycles_stop ( ) noexcept {
+    #if HAVE_RDTSC
+    unsigned int aux;
+    const std::uint64_t t = __rdtscp ( &aux );
+    _mm_lfence ( );
+    return t;
+    #else
+    return cycles ( );
+    #endif
+}
+
+// A log-linear (HDR) histogram of latencies (f.e. in cycles), values below 2^SubBucketBits are
+// counted exactly, above, every power of 2 is split into 2^( SubBucketBits - 1 ) sub-buckets,
+// i.e. the values are kept to a relative precision of 2^( 1 - SubBucketBits ) (1.6% by default,
+// in 30KiB). Recording is a bit scan, a shift and an increment. Histograms (f.e. per thread)
+// merge by adding their buckets.
+template<int SubBucketBits = 7>
+class latency_histogram {
+
+    static_assert ( SubBucketBits > 1 and SubBucketBits < 32, "sub-bucket bits should be in [ 2, 31 ]." );
+
+    static constexpr std::uint64_t half = std::uint64_t { 1 } << ( SubBucketBits - 1 );
+
+    public:
+
+    // The relative precision of the values (and percentiles), 2^( 1 - SubBucketBits ).
+    static constexpr double precision = 1.0 / static_cast<double> ( half );
+
+    latency_histogram ( ) :
+        buckets ( static_cast<std::size_t> ( index ( std::numeric_limits<std::uint64_t>::max ( ) ) + 1 ), 0 ) { }
+
+    void record ( std::uint64_t value, std::uint64_t count_ = 1 ) noexcept {
+        buckets [ static_cast<std::size_t> ( index ( value ) ) ] += count_;
+        n += count_;
+        min_value = std::min ( min_value, value );
+        max_value = std::max ( max_value, value );
+    }
+
+    // Records the cycles f ( ) takes (including the overhead of the serialized reads of the
+    // counter), and returns what f returns.
+    template<typename F>
+    decltype ( auto ) time ( F && f ) {
+        const std::uint64_t start = cycles_start ( );
+        if constexpr ( std::is_void<decltype ( f ( ) )>::value ) {
+            f ( );
+            record ( cycles_stop ( ) - start );
+        }
+        else {
+            decltype ( auto ) r = f ( );
+            record ( cycles_stop ( ) - start );
+            return r;
+        }
+    }
+
+    void merge ( const latency_histogram & o ) noexcept {
+        for ( std::size_t i = 0; i < buckets.size ( ); ++i ) {
+            buckets [ i ] += o.buckets [ i ];
+        }
+        n += o.n;
+        min_value = std::min ( min_value, o.min_value );
+        max_value = std::max ( max_value, o.max_value );
+    }
+
+    void reset ( ) noexcept {
+        std::fill ( buckets.begin ( ), buckets.end ( ), 0 );
+        n = 0;
+        min_value = std::numeric_limits<std::uint64_t>::max ( );
+        max_value = 0;
+    }
+
+    // Returns the value at percentile p (in [ 0, 100 ]), the highest value of the bucket holding
+    // it (but not above max ( )).
+    [[ nodiscard ]] std::uint64_t percentile ( double p ) const noexcept {
+        if ( not n ) {
+            return 0;
+        }
+        const std::uint64_t rank = std::max ( std::uint64_t { 1 }, static_cast<std::uint64_t> ( std::ceil ( std::min ( std::max ( p, 0.0 ), 100.0 ) / 100.0 * n ) ) );
+        std::uint64_t seen = 0;
+        for ( std::size_t i = 0; i < buckets.size ( ); ++i ) {
+            if ( ( seen += buckets [ i ] ) >= rank ) {
+                return std::min ( std::max ( highest ( i ), min_value ), max_value );
+            }
+        }
+        return max_value;
+    }
+
+    [[ nodiscard ]] long double mean ( ) const noexcept {
+        long double sum = 0.0;
+        for ( std::size_t i = 0; i < buckets.size ( ); ++i ) {
+            if ( buckets [ i ] ) {
+                sum += ( long double ) buckets [ i ] * ( ( long double ) lowest ( i ) + highest ( i ) ) / 2;
+            }
+        }
+        return n ? sum / n : 0.0;
+    }
+
+    [[ nodiscard ]] std::uint64_t count ( ) const noexcept {
+        return n;
+    }
+    [[ nodiscard ]] std::uint64_t min ( ) const noexcept {
+        return n ? min_value : 0;
+    }
+    [[ nodiscard ]] std::uint64_t max ( ) const noexcept {
+        return max_value;
+    }
+
+    private:
+
+    // The bucket of value, with shift = max ( 0, log2 ( value ) - ( SubBucketBits - 1 ) ),
+    // shift * half + ( value >> shift ).
+    [[ nodiscard ]] static std::uint64_t index ( std::uint64_t value ) noexcept {
+        const int shift = std::max ( 0, log2 ( value | 1 ) - ( SubBucketBits - 1 ) );
+        return static_cast<std::uint64_t> ( shift ) * half + ( value >> shift );
+    }
+
+    [[ nodiscard ]] static int shift_of ( std::size_t i ) noexcept {
+        return i < 2 * half ? 0 : static_cast<int> ( i / half ) - 1;
+    }
+    [[ nodiscard ]] static std::uint64_t lowest ( std::size_t i ) noexcept {
+        const int shift = shift_of ( i );
+        return ( i - static_cast<std::uint64_t> ( shift ) * half ) << shift;
+    }
+    [[ nodiscard ]] static std::uint64_t highest ( std::size_t i ) noexcept {
+        return lowest ( i ) + ( ( std::uint64_t { 1 } << shift_of ( i ) ) - 1 );
+    }
+
+    [[ nodiscard ]] static int log2 ( std::uint64_t x ) noexcept {
+        return 63 - static_cast<int> ( ext::detail::leading_zeros ( x ) );
+    }
+
+    std::vector<std::uint64_t> buckets;
+    std::uint64_t n = 0, min_value = std::numeric_limits<std::uint64_t>::max ( ), max_value = 0;
+};
+}
+
+
+// macro cleanup
+
+#undef GNU
+#undef MSVC
+#undef HAVE_RDTSC
@@ -0,0 +1,136 @@
+
+// MIT License
+//
+// Copyright (c) 2018 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include <array>
+#include <limits>
+#include <type_traits>
+
+#include "uniform_int_distribution_fast.hpp"
+
+#if _HAS_EXCEPTIONS == 0
+    #define NOEXCEPT
+#else
+    #define NOEXCEPT noexcept
+#endif
+
+
+namespace ext {
+
+// Draws a uniformly distributed cell ( x, y [, z ... ] ) from a grid of extents [ W, H [, D ... ] ].
+// One bounded draw is done over the product of the extents, the result is split into its
+// coordinates by reciprocal division (a multiply-high, no hardware div). If the product of the
+// extents does not fit in 64 bits, the coordinates are drawn per axis.
+template<std::size_t N, typename IndexType = std::size_t>
+class uniform_index_distribution {
+
+    static_assert ( N > 0, "at least one dimension is required." );
+    static_assert ( std::is_unsigned<IndexType>::value, "only unsigned index types are allowed." );
+
+    using range_type = std::uint64_t;
+    using distribution_type = uniform_int_distribution_fast<range_type>;
+    using divider_type = detail::reciprocal_divider<range_type>;
+
+    public:
+
+    using index_type = IndexType;
+    using result_type = std::array<index_type, N>;
+
+    explicit uniform_index_distribution ( const result_type & extents_ ) NOEXCEPT :
+        extents ( extents_ ) {
+        range_type size = 1;
+        for ( std::size_t i = 0; i < N; ++i ) {
+            assert ( extents [ i ] );
+            if ( size > std::numeric_limits<range_type>::max ( ) / extents [ i ] ) {
+                fused = false;
+            }
+            size *= extents [ i ];
+        }
+        if ( fused ) {
+            product = distribution_type ( 0, size - 1 );
+            for ( std::size_t i = 0; i < N - 1; ++i ) {
+                dividers [ i ] = divider_type ( extents [ i ] );
+            }
+        }
+        else {
+            for ( std::size_t i = 0; i < N; ++i ) {
+                axes [ i ] = distribution_type ( 0, extents [ i ] - 1 );
+            }
+        }
+    }
+
+    template<typename ... Extents, typename = std::enable_if_t<( sizeof ... ( Extents ) == N ) and std::conjunction<std::is_integral<Extents> ...>::value>>
+    explicit uniform_index_distribution ( Extents ... extents_ ) NOEXCEPT :
+        uniform_index_distribution ( result_type { { static_cast<index_type> ( extents_ ) ... } } ) { }
+
+    void reset ( ) const NOEXCEPT {
+    }
+
+    template<typename Gen>
+    [[ nodiscard ]] result_type operator ( ) ( Gen & rng ) const NOEXCEPT {
+        result_type cell;
+        if ( fused ) {
+            range_type r = product ( rng ), q;
+            for ( std::size_t i = 0; i < N - 1; ++i ) {
+                q = dividers [ i ].divide ( r, r );
+                cell [ i ] = index_type ( r );
+                r = q;
+            }
+            cell [ N - 1 ] = index_type ( r );
+        }
+        else {
+            for ( std::size_t i = 0; i < N; ++i ) {
+                cell [ i ] = index_type ( axes [ i ] ( rng ) );
+            }
+        }
+        return cell;
+    }
+
+    [[ nodiscard ]] const result_type & param ( ) const NOEXCEPT {
+        return extents;
+    }
+
+    // True if a cell is drawn with a single bounded draw.
+    [[ nodiscard ]] bool is_fused ( ) const NOEXCEPT {
+        return fused;
+    }
+
+    private:
+
+    result_type extents;
+    bool fused = true;
+    distribution_type product;
+    std::array<divider_type, ( N > 1 ? N - 1 : 1 )> dividers;
+    std::array<distribution_type, N> axes;
+};
+} // namespace ext
+
+
+// macro cleanup
+
+#undef NOEXCEPT
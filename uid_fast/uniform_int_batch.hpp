@@ -0,0 +1,122 @@
+
+// MIT License
+//
+// Copyright (c) 2018 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+
+#include "uniform_int_distribution_fast.hpp"
+
+#if defined ( _WIN32 ) && ! ( defined ( __clang__ ) || defined ( __GNUC__ ) ) // MSVC and not clang or gcc on windows.
+    #define GNU 0
+    #define MSVC 1
+#else
+    #define GNU 1
+    #define MSVC 0
+#endif
+
+#if _HAS_EXCEPTIONS == 0
+    #define NOEXCEPT
+#else
+    #define NOEXCEPT noexcept
+#endif
+
+#if GNU
+    #define COLD __attribute__ ( ( noinline, cold ) )
+    #define UNLIKELY( x ) __builtin_expect ( !!( x ), 0 )
+#else
+    #define COLD __declspec ( noinline )
+    #define UNLIKELY( x ) ( x )
+#endif
+
+
+namespace ext {
+
+namespace detail {
+
+// The slow path of Lemire's method for a single lane, only taken if the low half of the
+// product is less than the range, the threshold (and its division) is computed here.
+template<typename Rng, typename UIntType>
+COLD UIntType bounded_batch_reject ( Rng & rng, const UIntType range, UIntType l, UIntType h ) NOEXCEPT {
+    const UIntType t = UIntType ( 0 - range ) % range;
+    while ( l < t ) {
+        h = wide_multiply<UIntType> ( UIntType ( rng ( ) ), range, l );
+    }
+    return h;
+}
+} // namespace detail
+
+
+// Draws out [ i ] uniformly from [ 0, ranges [ i ] ), for every i in [ 0, n ), f.e. the
+// per-bucket sizes, per-node degrees or the decreasing ranges of a shuffle. The engine words
+// are generated and multiplied per block (the multiply-high vectorizes for 16- and 32-bit
+// ranges), thresholds are only computed for the (rare) lanes where the low half of the product
+// is less than the range. The ranges are required to be non-zero.
+template<typename Gen, typename UIntType>
+void bounded_batch ( Gen & rng, const UIntType * ranges, UIntType * out, std::size_t n ) NOEXCEPT {
+    static_assert ( std::is_unsigned<UIntType>::value and detail::is_distribution_result_type<UIntType>::value, "only 16-, 32- and 64-bit unsigned range types are allowed." );
+    constexpr std::size_t block_size = 64;
+    constexpr bool full_width_gen = std::is_same<typename Gen::result_type, UIntType>::value and
+                                    ( Gen::min ( ) == 0 ) and ( Gen::max ( ) == std::numeric_limits<UIntType>::max ( ) );
+    detail::bits_engine<Gen, UIntType, ( Gen::max ( ) < std::numeric_limits<UIntType>::max ( ) )> rng_ref ( rng );
+    UIntType x [ block_size ], l [ block_size ];
+    while ( n ) {
+        const std::size_t m = std::min ( n, block_size );
+        if constexpr ( full_width_gen ) {
+            detail::generate ( rng, x, x + m );
+        }
+        else {
+            for ( std::size_t i = 0; i < m; ++i ) {
+                x [ i ] = UIntType ( rng_ref ( ) );
+            }
+        }
+        for ( std::size_t i = 0; i < m; ++i ) {
+            assert ( ranges [ i ] );
+            out [ i ] = detail::wide_multiply<UIntType> ( x [ i ], ranges [ i ], l [ i ] );
+        }
+        for ( std::size_t i = 0; i < m; ++i ) {
+            if ( UNLIKELY ( l [ i ] < ranges [ i ] ) ) {
+                out [ i ] = detail::bounded_batch_reject ( rng_ref, ranges [ i ], l [ i ], out [ i ] );
+            }
+        }
+        ranges += m;
+        out += m;
+        n -= m;
+    }
+}
+} // namespace ext
+
+
+// macro cleanup
+
+#undef UNLIKELY
+#undef COLD
+#undef GNU
+#undef MSVC
+#undef NOEXCEPT
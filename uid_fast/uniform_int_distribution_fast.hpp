@@ -49,6 +49,7 @@
 #include <limits>
 #include <random>
 #include <type_traits>
+#include <utility>
 
 #if defined ( _WIN32 ) && ! ( defined ( __clang__ ) || defined ( __GNUC__ ) ) // MSVC and not clang or gcc on windows.
     #include <intrin.h>
@@ -85,58 +86,76 @@
     #define NOEXCEPT noexcept
 #endif
 
-#if HAVE_ABSEIL and M32
-    #include <absl/numeric/int128.h>
+#if defined ( __clang__ ) ? ( __clang_major__ >= 9 ) : defined ( __GNUC__ ) ? ( __GNUC__ >= 9 ) : ( _MSC_VER >= 1925 )
+    #define HAVE_IS_CONSTANT_EVALUATED 1
+#else
+    #define HAVE_IS_CONSTANT_EVALUATED 0
 #endif
-#define USE_ABSEIL ( HAVE_ABSEIL and M32 )
 
 
 namespace ext {
 
-template<typename IntType = int>
+namespace algorithm {
+struct lemire;
+}
+
+template<typename IntType = int, typename Algorithm = algorithm::lemire>
 class uniform_int_distribution_fast;
 
 namespace detail {
 
-template<typename RangeType>
-constexpr bool br_lemire_oneill ( ) NOEXCEPT {
-    return true; /* ( CLANG and M64 ) or
-           ( CLANG and M32 and not ( std::is_same<RangeType, std::uint64_t>::value ) ) or
-           ( MSVC and M32 and not ( std::is_same<RangeType, std::uint64_t>::value ) ); */
+// Returns true if evaluated in a constant expression (where the intrinsics are not available).
+constexpr bool is_constant_evaluated ( ) NOEXCEPT {
+    #if HAVE_IS_CONSTANT_EVALUATED
+    return __builtin_is_constant_evaluated ( );
+    #else
+    return false;
+    #endif
 }
 
-template<typename RangeType>
-constexpr bool br_bitmask ( ) NOEXCEPT {
-    return not ( br_lemire_oneill<RangeType> ( ) );
+// Requires x != 0.
+template<typename Type>
+[[ nodiscard ]] constexpr std::uint32_t leading_zeros_portable ( Type x ) NOEXCEPT {
+    std::uint32_t n = 0;
+    for ( int shift = std::numeric_limits<Type>::digits / 2; shift; shift /= 2 ) {
+        if ( not ( x >> ( std::numeric_limits<Type>::digits - shift ) ) ) {
+            n += shift;
+            x <<= shift;
+        }
+    }
+    return n;
 }
 
-struct uint32uint32_t {
-    std::uint32_t low, high;
-};
-
 template<typename Type>
-std::uint32_t leading_zeros ( Type x ) NOEXCEPT {
+[[ nodiscard ]] constexpr std::uint32_t leading_zeros ( Type x ) NOEXCEPT {
     if constexpr ( std::is_same<Type, std::uint64_t>::value ) {
         if constexpr ( M32 ) {
+            const std::uint32_t high = static_cast<std::uint32_t> ( x >> 32 ), low = static_cast<std::uint32_t> ( x );
             if constexpr ( MSVC ) {
+                if ( is_constant_evaluated ( ) ) {
+                    return leading_zeros_portable ( x );
+                }
                 unsigned long c = 0u;
-                if ( !( ( *reinterpret_cast<uint32uint32_t*> ( &x ) ).high ) ) {
-                    _BitScanReverse ( &c, ( *reinterpret_cast<uint32uint32_t*> ( &x ) ).low );
+                if ( not high ) {
+                    _BitScanReverse ( &c, low );
                     return 63u - c;
                 }
-                _BitScanReverse ( &c, ( *reinterpret_cast<uint32uint32_t*> ( &x ) ).high );
+                _BitScanReverse ( &c, high );
                 return 31u - c;
             }
             else { // GNU.
-                if ( !( ( *reinterpret_cast<uint32uint32_t*> ( &x ) ).high ) ) {
-                    return __builtin_clz ( ( *reinterpret_cast<uint32uint32_t*> ( &x ) ).low ) + 32;
+                if ( not high ) {
+                    return __builtin_clz ( low ) + 32;
                 }
-                return __builtin_clz ( ( *reinterpret_cast<uint32uint32_t*> ( &x ) ).high );
+                return __builtin_clz ( high );
             }
         }
         else { // M64.
             if constexpr ( MSVC ) {
-                unsigned long c;
+                if ( is_constant_evaluated ( ) ) {
+                    return leading_zeros_portable ( x );
+                }
+                unsigned long c = 0u;
                 _BitScanReverse64 ( &c, x );
                 return static_cast<std::uint32_t> ( std::numeric_limits<Type>::digits - 1 ) - c;
             }
@@ -147,25 +166,38 @@ std::uint32_t leading_zeros ( Type x ) NOEXCEPT {
     }
     else { // 16 or 32 bits.
         if constexpr ( MSVC ) {
-            unsigned long c;
+            if ( is_constant_evaluated ( ) ) {
+                return leading_zeros_portable ( x );
+            }
+            unsigned long c = 0u;
             _BitScanReverse ( &c, static_cast<std::uint32_t> ( x ) );
             return static_cast<std::uint32_t> ( std::numeric_limits<Type>::digits - 1 ) - c;
         }
         else { // GNU.
-            return __builtin_clz ( static_cast<std::uint32_t> ( x ) );
+            return __builtin_clz ( static_cast<std::uint32_t> ( x ) ) - ( 32 - std::numeric_limits<Type>::digits );
         }
     }
 }
 
+// As std::reference_wrapper, but usable in constant expressions (C++17).
 template<typename Gen>
-struct generator_reference : public std::reference_wrapper<Gen> {
-
-    using std::reference_wrapper<Gen>::reference_wrapper;
+struct generator_reference {
 
     using result_type = typename Gen::result_type;
 
+    constexpr generator_reference ( Gen & gen_ ) NOEXCEPT :
+        gen ( &gen_ ) { }
+
+    [[ nodiscard ]] constexpr result_type operator ( ) ( ) {
+        return ( *gen ) ( );
+    }
+
     [[ nodiscard ]] static constexpr result_type min ( ) NOEXCEPT { return Gen::min ( ); }
     [[ nodiscard ]] static constexpr result_type max ( ) NOEXCEPT { return Gen::max ( ); }
+
+    private:
+
+    Gen * gen;
 };
 
 template<typename Gen, typename UnsignedResultType, bool HasBitEngine>
@@ -176,20 +208,452 @@ struct bits_engine<Gen, UnsignedResultType, true> : public std::independent_bits
 };
 template<typename Gen, typename UnsignedResultType>
 struct bits_engine<Gen, UnsignedResultType, false> : public generator_reference<Gen> {
-    explicit bits_engine ( Gen & gen ) : generator_reference<Gen> ( gen ) { }
+    explicit constexpr bits_engine ( Gen & gen ) : generator_reference<Gen> ( gen ) { }
 };
 
 template<typename IT> struct double_width_integer { };
 template<> struct double_width_integer<std::uint8_t > { using type = std::uint16_t; };
 template<> struct double_width_integer<std::uint16_t> { using type = std::uint32_t; };
 template<> struct double_width_integer<std::uint32_t> { using type = std::uint64_t; };
-#if USE_ABSEIL
-template<> struct double_width_integer<std::uint64_t> { using type = absl::uint128; };
-#endif
 #if GNU and M64
 template<> struct double_width_integer<std::uint64_t> { using type = __uint128_t; };
 #endif
 
+// Returns the high half of the product a * b, composed of 32 x 32 bit partial products (as
+// on 32-bit targets), the low half is returned in l. If b fits in 32 bits (f.e. most ranges),
+// two partial products suffice.
+[[ nodiscard ]] constexpr std::uint64_t wide_multiply_portable ( const std::uint64_t a, const std::uint64_t b, std::uint64_t & l ) NOEXCEPT {
+    const std::uint32_t a_lo = static_cast<std::uint32_t> ( a ), a_hi = static_cast<std::uint32_t> ( a >> 32 );
+    const std::uint32_t b_lo = static_cast<std::uint32_t> ( b ), b_hi = static_cast<std::uint32_t> ( b >> 32 );
+    const std::uint64_t ll = std::uint64_t { a_lo } * b_lo, hl = std::uint64_t { a_hi } * b_lo;
+    if ( not b_hi ) {
+        const std::uint64_t mid = hl + ( ll >> 32 ); // can't overflow.
+        l = ( mid << 32 ) | static_cast<std::uint32_t> ( ll );
+        return mid >> 32;
+    }
+    const std::uint64_t lh = std::uint64_t { a_lo } * b_hi, hh = std::uint64_t { a_hi } * b_hi;
+    const std::uint64_t mid = ( ll >> 32 ) + static_cast<std::uint32_t> ( lh ) + static_cast<std::uint32_t> ( hl );
+    l = ( mid << 32 ) | static_cast<std::uint32_t> ( ll );
+    return hh + ( lh >> 32 ) + ( hl >> 32 ) + ( mid >> 32 );
+}
+
+// Returns the high half of the double-width product a * b, the low half is returned in l.
+template<typename Type>
+[[ nodiscard ]] constexpr Type wide_multiply ( Type a, Type b, Type & l ) NOEXCEPT {
+    if constexpr ( std::is_same<Type, std::uint64_t>::value and not ( GNU and M64 ) ) {
+        #if MSVC and M64
+        if ( not is_constant_evaluated ( ) ) {
+            Type h = 0;
+            l = _umul128 ( a, b, &h );
+            return h;
+        }
+        #endif
+        return wide_multiply_portable ( a, b, l );
+    }
+    else {
+        using double_width_type = typename double_width_integer<Type>::type;
+        const double_width_type m = double_width_type ( a ) * double_width_type ( b );
+        l = Type ( m );
+        return Type ( m >> std::numeric_limits<Type>::digits );
+    }
+}
+
+template<typename Gen, typename It, typename = void>
+struct has_generate : std::false_type { };
+template<typename Gen, typename It>
+struct has_generate<Gen, It, std::void_t<decltype ( std::declval<Gen &> ( ).generate ( std::declval<It> ( ), std::declval<It> ( ) ) )>> : std::true_type { };
+
+// Fill [ first, last ) with raw engine output, in bulk if the engine supports it.
+template<typename Gen, typename It>
+void generate ( Gen & gen, It first, const It last ) NOEXCEPT {
+    if constexpr ( has_generate<Gen, It>::value ) {
+        gen.generate ( first, last );
+    }
+    else {
+        while ( first != last ) {
+            *first++ = gen ( );
+        }
+    }
+}
+
+// Division by a run-time invariant divisor, as a multiply-high and shifts with a pre-computed
+// reciprocal (the libdivide algorithm: https://libdivide.com).
+template<typename UIntType>
+class reciprocal_divider {
+
+    static_assert ( std::is_same<UIntType, std::uint32_t>::value or std::is_same<UIntType, std::uint64_t>::value, "only 32- and 64-bit divisors are allowed." );
+
+    static constexpr int digits = std::numeric_limits<UIntType>::digits;
+
+    public:
+
+    reciprocal_divider ( ) NOEXCEPT :
+        reciprocal_divider ( UIntType { 1 } ) { }
+    explicit reciprocal_divider ( UIntType d ) NOEXCEPT :
+        divisor ( d ) {
+        assert ( d );
+        shift = digits - 1 - static_cast<int> ( leading_zeros<UIntType> ( d ) ); // floor ( log2 ( d ) ).
+        if ( not ( d & ( d - 1 ) ) ) { // power of 2.
+            magic = 0;
+            return;
+        }
+        UIntType r, m = divide_wide ( UIntType { 1 } << shift, d, r ); // floor ( 2 ^ ( digits + shift ) / d ).
+        if ( ( d - r ) < ( UIntType { 1 } << shift ) ) {
+            add = false;
+        }
+        else {
+            m += m;
+            const UIntType r2 = r + r;
+            if ( r2 >= d or r2 < r ) {
+                ++m;
+            }
+            add = true;
+        }
+        magic = m + 1;
+    }
+
+    [[ nodiscard ]] UIntType divide ( UIntType n ) const NOEXCEPT {
+        if ( not magic ) {
+            return n >> shift;
+        }
+        UIntType l, q = wide_multiply<UIntType> ( n, magic, l );
+        if ( add ) {
+            return ( ( ( n - q ) >> 1 ) + q ) >> shift;
+        }
+        return q >> shift;
+    }
+
+    // Returns n / divisor, the remainder is returned in r.
+    [[ nodiscard ]] UIntType divide ( UIntType n, UIntType & r ) const NOEXCEPT {
+        const UIntType q = divide ( n );
+        r = n - q * divisor;
+        return q;
+    }
+
+    [[ nodiscard ]] UIntType value ( ) const NOEXCEPT {
+        return divisor;
+    }
+
+    private:
+
+    // Returns floor ( ( h * 2 ^ digits ) / d ), requires h < d, bit by bit, only used at construction.
+    [[ nodiscard ]] static UIntType divide_wide ( UIntType h, const UIntType d, UIntType & r ) NOEXCEPT {
+        UIntType q = 0;
+        for ( int i = 0; i < digits; ++i ) {
+            const bool carry = h >> ( digits - 1 );
+            h <<= 1;
+            q <<= 1;
+            if ( carry or h >= d ) {
+                h -= d;
+                q |= 1;
+            }
+        }
+        r = h;
+        return q;
+    }
+
+    UIntType divisor, magic;
+    int shift;
+    bool add = false;
+};
+
+// Returns 2^digits % range, the modulo is avoided if 2^digits - range < 2 * range (as is the
+// case for all range > 2^digits / 3).
+template<typename RangeType>
+[[ nodiscard ]] constexpr RangeType threshold ( const RangeType range ) NOEXCEPT {
+    RangeType t = RangeType ( 0 - range );
+    if ( t >= range ) {
+        t -= range;
+        if ( t >= range ) {
+            t %= range;
+        }
+    }
+    return t;
+}
+
+} // namespace detail
+
+
+// The algorithm policies of uniform_int_distribution_fast, each maps the output of an engine
+// (of word_type width) onto [ 0, range ), for range in [ 1, 2^digits ), the full range is dealt
+// with by the distribution. With the exception of canon and fixed, these are the variants of
+// bounded_rand as benchmarked by Melissa E. O'Neill:
+// http://www.pcg-random.org/posts/bounded-rands.html
+namespace algorithm {
+
+struct policy {
+    // The type of the engine words the algorithm consumes.
+    template<typename RangeType>
+    using word_type = RangeType;
+};
+
+// Lemire's method, multiply, reject on the low half, https://arxiv.org/abs/1805.10941, the
+// threshold ( 2^digits % range ) is only computed if the low half is below range (as it is
+// below the threshold only then), the draws are the same.
+struct lemire : policy {
+    template<typename Rng, typename RangeType>
+    [[ nodiscard ]] static constexpr RangeType generate ( Rng & rng, const RangeType range ) NOEXCEPT {
+        RangeType l = 0, h = detail::wide_multiply<RangeType> ( RangeType ( rng ( ) ), range, l );
+        if ( l < range ) {
+            const RangeType t = detail::threshold ( range );
+            while ( l < t ) {
+                h = detail::wide_multiply<RangeType> ( RangeType ( rng ( ) ), range, l );
+            }
+        }
+        return h;
+    }
+};
+
+// Lemire's method, with O'Neill's optimizations, the threshold is only computed (and the modulo
+// mostly avoided) if the low half is below range, large ranges are rejection sampled directly.
+struct lemire_oneill : policy {
+    template<typename Rng, typename RangeType>
+    [[ nodiscard ]] static constexpr RangeType generate ( Rng & rng, const RangeType range ) NOEXCEPT {
+        RangeType x = RangeType ( rng ( ) );
+        if ( range >= RangeType ( RangeType { 1 } << ( std::numeric_limits<RangeType>::digits - 1 ) ) ) {
+            while ( x >= range ) {
+                x = RangeType ( rng ( ) );
+            }
+            return x;
+        }
+        RangeType l = 0, h = detail::wide_multiply<RangeType> ( x, range, l );
+        if ( l < range ) {
+            RangeType t = RangeType ( 0 - range );
+            t -= range;
+            if ( t >= range ) {
+                t %= range;
+            }
+            while ( l < t ) {
+                h = detail::wide_multiply<RangeType> ( RangeType ( rng ( ) ), range, l );
+            }
+        }
+        return h;
+    }
+};
+
+// Canon's method, as analysed in https://arxiv.org/abs/2304.09960: the high half of
+// x * range is the result, unless the low half is so large that the contribution of the
+// next word(s) of the fraction 0.x0x1x2... could carry into it. Only then the next word is
+// drawn and the carry is resolved exactly, no division is ever required.
+struct canon : policy {
+    template<typename Rng, typename RangeType>
+    [[ nodiscard ]] static constexpr RangeType generate ( Rng & rng, const RangeType range ) NOEXCEPT {
+        RangeType l = 0, h = detail::wide_multiply<RangeType> ( RangeType ( rng ( ) ), range, l );
+        if ( l > RangeType ( 0 - range ) ) {
+            RangeType l2 = 0, s = 0;
+            do {
+                s = l + detail::wide_multiply<RangeType> ( RangeType ( rng ( ) ), range, l2 );
+                if ( s < l ) { // carry.
+                    ++h;
+                    break;
+                }
+                l = l2;
+            } while ( s == std::numeric_limits<RangeType>::max ( ) ); // undecided, carry from the next word.
+        }
+        return h;
+    }
+};
+
+// Masks off the bits above the highest bit of range - 1 and rejects values out of range.
+struct bitmask : policy {
+    template<typename Rng, typename RangeType>
+    [[ nodiscard ]] static constexpr RangeType generate ( Rng & rng, RangeType range ) NOEXCEPT {
+        --range;
+        const RangeType mask = std::numeric_limits<RangeType>::max ( ) >> detail::leading_zeros<RangeType> ( range | RangeType { 1 } );
+        RangeType x = 0;
+        do {
+            x = RangeType ( rng ( ) ) & mask;
+        } while ( x > range );
+        return x;
+    }
+};
+
+// Divides by the size of the largest multiple of range fitting in the word, rejects the tail.
+struct debiased_div : policy {
+    template<typename Rng, typename RangeType>
+    [[ nodiscard ]] static constexpr RangeType generate ( Rng & rng, const RangeType range ) NOEXCEPT {
+        const RangeType divisor = RangeType ( RangeType ( 0 - range ) / range ) + 1;
+        if ( 0 == divisor ) { // range is 1.
+            return 0;
+        }
+        RangeType x = 0;
+        do {
+            x = RangeType ( rng ( ) ) / divisor;
+        } while ( x >= range );
+        return x;
+    }
+};
+
+// Modulo, rejects (and redraws) if x is in the incomplete last multiple of range.
+struct modx1 : policy {
+    template<typename Rng, typename RangeType>
+    [[ nodiscard ]] static constexpr RangeType generate ( Rng & rng, const RangeType range ) NOEXCEPT {
+        RangeType x = 0, r = 0;
+        do {
+            x = RangeType ( rng ( ) );
+            r = x % range;
+        } while ( RangeType ( x - r ) > RangeType ( 0 - range ) );
+        return r;
+    }
+};
+
+// As modx1, large ranges are rejection sampled directly.
+struct modx1_bopt : policy {
+    template<typename Rng, typename RangeType>
+    [[ nodiscard ]] static constexpr RangeType generate ( Rng & rng, const RangeType range ) NOEXCEPT {
+        if ( range >= RangeType ( RangeType { 1 } << ( std::numeric_limits<RangeType>::digits - 1 ) ) ) {
+            RangeType x = 0;
+            do {
+                x = RangeType ( rng ( ) );
+            } while ( x >= range );
+            return x;
+        }
+        return modx1::generate ( rng, range );
+    }
+};
+
+// As modx1, the modulo is avoided if x < 2 * range.
+struct modx1_mopt : policy {
+    template<typename Rng, typename RangeType>
+    [[ nodiscard ]] static constexpr RangeType generate ( Rng & rng, const RangeType range ) NOEXCEPT {
+        RangeType x = 0, r = 0;
+        do {
+            x = RangeType ( rng ( ) );
+            r = x;
+            if ( r >= range ) {
+                r -= range;
+                if ( r >= range ) {
+                    r %= range;
+                }
+            }
+        } while ( RangeType ( x - r ) > RangeType ( 0 - range ) );
+        return r;
+    }
+};
+
+// Rejects below the threshold 2^digits % range, then reduces by modulo.
+struct debiased_modx2 : policy {
+    template<typename Rng, typename RangeType>
+    [[ nodiscard ]] static constexpr RangeType generate ( Rng & rng, const RangeType range ) NOEXCEPT {
+        const RangeType t = RangeType ( 0 - range ) % range;
+        RangeType x = 0;
+        do {
+            x = RangeType ( rng ( ) );
+        } while ( x < t );
+        return x % range;
+    }
+};
+
+// As debiased_modx2, the threshold is only computed if x < range (it's smaller than range).
+struct modx2_topt : policy {
+    template<typename Rng, typename RangeType>
+    [[ nodiscard ]] static constexpr RangeType generate ( Rng & rng, const RangeType range ) NOEXCEPT {
+        RangeType x = RangeType ( rng ( ) );
+        if ( x < range ) {
+            const RangeType t = RangeType ( 0 - range ) % range;
+            while ( x < t ) {
+                x = RangeType ( rng ( ) );
+            }
+        }
+        return x % range;
+    }
+};
+
+// As modx2_topt, large ranges are rejection sampled directly.
+struct modx2_topt_bopt : policy {
+    template<typename Rng, typename RangeType>
+    [[ nodiscard ]] static constexpr RangeType generate ( Rng & rng, const RangeType range ) NOEXCEPT {
+        if ( range >= RangeType ( RangeType { 1 } << ( std::numeric_limits<RangeType>::digits - 1 ) ) ) {
+            RangeType x = 0;
+            do {
+                x = RangeType ( rng ( ) );
+            } while ( x >= range );
+            return x;
+        }
+        return modx2_topt::generate ( rng, range );
+    }
+};
+
+// As modx2_topt, the modulo computing the threshold is avoided if 2^digits - range < 2 * range.
+struct modx2_topt_mopt : policy {
+    template<typename Rng, typename RangeType>
+    [[ nodiscard ]] static constexpr RangeType generate ( Rng & rng, const RangeType range ) NOEXCEPT {
+        RangeType x = RangeType ( rng ( ) );
+        if ( x < range ) {
+            const RangeType t = detail::threshold ( range );
+            while ( x < t ) {
+                x = RangeType ( rng ( ) );
+            }
+        }
+        return x % range;
+    }
+};
+
+// As modx2_topt_mopt, the final modulo is avoided as well if x < 2 * range.
+struct modx2_topt_moptx2 : policy {
+    template<typename Rng, typename RangeType>
+    [[ nodiscard ]] static constexpr RangeType generate ( Rng & rng, const RangeType range ) NOEXCEPT {
+        RangeType x = RangeType ( rng ( ) );
+        if ( x < range ) {
+            const RangeType t = detail::threshold ( range );
+            while ( x < t ) {
+                x = RangeType ( rng ( ) );
+            }
+        }
+        if ( x >= range ) {
+            x -= range;
+            if ( x >= range ) {
+                x %= range;
+            }
+        }
+        return x;
+    }
+};
+
+// A bounded-latency, branch-free algorithm for real-time and timing-sensitive callers, every
+// draw takes exactly 1 + ExtraWords 64-bit engine words and no rejection loop is run. The
+// result is the high word of the product of range and the ( 1 + ExtraWords ) word fraction
+// 0.w0w1w2..., i.e. floor ( range * X ) for a uniform X in [ 0, 1 ), the carry is propagated
+// with add/adc. The price is a (tiny) bias, the probability of any value deviates from 1 / range
+// by a relative error of less than 2^-(64 * ExtraWords), f.e. 2^-128 for the default.
+template<std::size_t ExtraWords = 2>
+struct fixed {
+
+    static_assert ( ExtraWords > 0, "at least one extra word is required." );
+
+    template<typename RangeType>
+    using word_type = std::uint64_t;
+
+    template<typename Rng, typename RangeType>
+    [[ nodiscard ]] static constexpr RangeType generate ( Rng & rng, const RangeType range ) NOEXCEPT {
+        std::uint64_t carry = 0, l = 0;
+        for ( std::size_t i = 0; i <= ExtraWords; ++i ) { // least significant word first.
+            const std::uint64_t h = detail::wide_multiply<std::uint64_t> ( std::uint64_t ( rng ( ) ), std::uint64_t { range }, l );
+            l += carry;
+            carry = h + ( l < carry );
+        }
+        return RangeType ( carry );
+    }
+};
+
+// Canon's method for 64-bit ranges (where the 64-bit modulo of Lemire's threshold is slow on
+// most targets), Lemire's method (the default) otherwise, opt-in.
+struct automatic : policy {
+    template<typename Rng, typename RangeType>
+    [[ nodiscard ]] static constexpr RangeType generate ( Rng & rng, const RangeType range ) NOEXCEPT {
+        if constexpr ( std::is_same<RangeType, std::uint64_t>::value ) {
+            return canon::generate ( rng, range );
+        }
+        else {
+            return lemire::generate ( rng, range );
+        }
+    }
+};
+} // namespace algorithm
+
+
+namespace detail {
+
 template<typename IntType>
 using is_distribution_result_type =
 std::disjunction <
@@ -206,14 +670,11 @@ struct param_type {
 
     using range_type = typename std::make_unsigned<result_type>::type;
 
-    friend class ::ext::uniform_int_distribution_fast<result_type>;
+    friend Distribution;
 
-    explicit param_type ( result_type min_, result_type max_ ) NOEXCEPT :
+    explicit constexpr param_type ( result_type min_, result_type max_ ) NOEXCEPT :
         min ( min_ ),
         range ( max_ - min_ + 1 ) { // wraps to 0 for unsigned max.
-        if constexpr ( br_bitmask<range_type> ( ) ) {
-            --range;
-        }
     }
 
     [[ nodiscard ]] constexpr bool operator == ( const param_type & rhs ) const NOEXCEPT {
@@ -229,12 +690,7 @@ struct param_type {
     }
 
     [[ nodiscard ]] constexpr result_type b ( ) const NOEXCEPT {
-        if constexpr ( br_lemire_oneill<range_type> ( ) ) {
-            return range ? range + min - 1 : std::numeric_limits<result_type>::max ( );
-        }
-        if constexpr ( br_bitmask<range_type> ( ) ) {
-            return ( range + 1 ) ? range + min : std::numeric_limits<result_type>::max ( );
-        }
+        return range ? range + min - 1 : std::numeric_limits<result_type>::max ( );
     }
 
     private:
@@ -245,8 +701,10 @@ struct param_type {
 } // namespace detail
 
 
-template<typename IntType>
-class uniform_int_distribution_fast : public detail::param_type<IntType, uniform_int_distribution_fast<IntType>> {
+// The algorithm mapping the engine output onto the range is selected by the policy Algorithm,
+// one of the types in ext::algorithm.
+template<typename IntType, typename Algorithm>
+class uniform_int_distribution_fast : public detail::param_type<IntType, uniform_int_distribution_fast<IntType, Algorithm>> {
 
     static_assert ( detail::is_distribution_result_type<IntType>::value, "only 16-, 32- and 64-bit result_types are allowed." );
 
@@ -254,6 +712,7 @@ class uniform_int_distribution_fast : public detail::param_type<IntType, uniform
 
     using result_type = IntType;
     using param_type = detail::param_type<result_type, uniform_int_distribution_fast>;
+    using algorithm_type = Algorithm;
 
     private:
 
@@ -261,149 +720,92 @@ class uniform_int_distribution_fast : public detail::param_type<IntType, uniform
 
     using pt = param_type;
     using range_type = typename std::make_unsigned<result_type>::type;
-
-    [[ nodiscard ]] constexpr range_type range_mask ( ) const NOEXCEPT {
-        return range_type { 1 } << ( std::numeric_limits<range_type>::digits - 1 );
-    }
+    using word_type = typename Algorithm::template word_type<range_type>;
 
     template<typename Gen>
-    using generator_reference = detail::bits_engine<Gen, range_type, ( Gen::max ( ) < std::numeric_limits<range_type>::max ( ) )>;
+    using generator_reference = detail::bits_engine<Gen, word_type, ( Gen::max ( ) < std::numeric_limits<word_type>::max ( ) )>;
 
     public:
 
-    explicit uniform_int_distribution_fast ( ) NOEXCEPT :
+    explicit constexpr uniform_int_distribution_fast ( ) NOEXCEPT :
         param_type ( std::numeric_limits<result_type>::min ( ), std::numeric_limits<result_type>::max ( ) ) { }
-    explicit uniform_int_distribution_fast ( result_type a, result_type b = std::numeric_limits<result_type>::max ( ) ) NOEXCEPT :
+    explicit constexpr uniform_int_distribution_fast ( result_type a, result_type b = std::numeric_limits<result_type>::max ( ) ) NOEXCEPT :
         param_type ( a, b ) {
         assert ( b >= a );
     }
-    explicit uniform_int_distribution_fast ( const param_type & params_ ) NOEXCEPT :
+    explicit constexpr uniform_int_distribution_fast ( const param_type & params_ ) NOEXCEPT :
         param_type ( params_ ) {
     }
 
-    void reset ( ) const NOEXCEPT {
+    constexpr void reset ( ) const NOEXCEPT {
     }
 
     template<typename Gen>
-    [[ nodiscard ]] result_type operator ( ) ( Gen & rng ) const NOEXCEPT {
+    [[ nodiscard ]] constexpr result_type operator ( ) ( Gen & rng ) const NOEXCEPT {
         generator_reference<Gen> rng_ref ( rng );
         if ( 0 == pt::range ) { // deal with interval [ std::numeric_limits<result_type>::min ( ), std::numeric_limits<result_type>::max ( ) ].
-            return static_cast< result_type > ( rng_ref ( ) );
-        }
-        if constexpr ( detail::br_lemire_oneill<range_type> ( ) ) {
-            return bounded_range_lemire ( rng_ref ) + pt::min;
-        }
-        if constexpr ( detail::br_bitmask<range_type> ( ) ) {
-            return bounded_range_bitmask ( rng_ref ) + pt::min;
+            return static_cast<result_type> ( rng_ref ( ) );
         }
+        return static_cast<result_type> ( range_type ( Algorithm::generate ( rng_ref, pt::range ) + range_type ( pt::min ) ) );
     }
 
-    [[ nodiscard ]] param_type param ( ) const NOEXCEPT {
+    [[ nodiscard ]] constexpr param_type param ( ) const NOEXCEPT {
         return *this;
     }
 
-    void param ( const param_type & params ) NOEXCEPT {
-        *this = params;
+    constexpr void param ( const param_type & params ) NOEXCEPT {
+        static_cast<param_type &> ( *this ) = params;
     }
+};
 
-    private:
+// uniform_int_distribution_fast with the bounded-latency, branch-free algorithm::fixed.
+template<typename IntType = int, std::size_t ExtraWords = 2>
+using uniform_int_distribution_fixed = uniform_int_distribution_fast<IntType, algorithm::fixed<ExtraWords>>;
 
-    template<typename Rng>
-    result_type bounded_range_bitmask ( Rng & rng ) const NOEXCEPT {
-        range_type mask = std::numeric_limits<range_type>::max ( );
-        mask >>= detail::leading_zeros<range_type> ( pt::range | range_type { 1 } );
-        range_type x;
-        do {
-            x = rng ( ) & mask;
-        } while ( x > pt::range );
-        return result_type ( x );
-    }
 
-    template<typename Rng>
-    result_type bounded_range_lemire ( Rng & rng ) const NOEXCEPT {
-        #if MSVC and M64
-        if constexpr ( std::is_same<range_type, std::uint64_t>::value ) {
-            const range_type t = ( 0 - pt::range ) % pt::range;
-            range_type x = rng ( );
-            range_type h, l = _umul128 ( x, pt::range, &h );
-            while ( l < t ) {
-                x = rng ( );
-                l = _umul128 ( x, pt::range, &h );
-            };
-            return result_type ( h );
-        }
-        else { // pt::range is of type std::uint32_t.
-        #endif
-            using double_width_unsigned_result_type = typename detail::double_width_integer<range_type>::type;
-            const range_type t = ( 0 - pt::range ) % pt::range;
-            range_type x = rng ( );
-            double_width_unsigned_result_type m = double_width_unsigned_result_type ( x ) * double_width_unsigned_result_type ( pt::range );
-            range_type l = range_type ( m );
-            while ( l < t ) {
-                x = rng ( );
-                m = double_width_unsigned_result_type ( x ) * double_width_unsigned_result_type ( pt::range );
-                l = range_type ( m );
-            };
-            return result_type ( m >> std::numeric_limits<range_type>::digits );
-        #if MSVC and M64
+namespace detail {
+
+// Lemire's method, the multiply is done first, the threshold is only computed if the low half
+// is below range, i.e. with probability range / 2^digits, and then requires a division only
+// for range <= 2^digits / 3.
+template<typename RangeType, typename Rng>
+[[ nodiscard ]] constexpr RangeType bounded_lazy ( Rng & rng, const RangeType range ) NOEXCEPT {
+    RangeType l = 0, h = wide_multiply<RangeType> ( RangeType ( rng ( ) ), range, l );
+    if ( l < range ) {
+        const RangeType t = threshold ( range );
+        while ( l < t ) {
+            h = wide_multiply<RangeType> ( RangeType ( rng ( ) ), range, l );
         }
-        #endif
     }
+    return h;
+}
+} // namespace detail
 
-    template<typename Rng>
-    result_type bounded_range_lemire_oneill ( Rng & rng ) const NOEXCEPT {
-        #if MSVC and M64
-        if constexpr ( std::is_same<range_type, std::uint64_t>::value ) {
-            range_type x = rng ( );
-            if ( pt::range >= range_mask ( ) ) {
-                do {
-                    x = rng ( );
-                } while ( x >= pt::range );
-                return result_type ( x );
-            }
-            range_type h, l = _umul128 ( x, pt::range, &h );
-            if ( l < pt::range ) {
-                range_type t = ( 0 - pt::range );
-                t -= pt::range;
-                if ( t >= pt::range ) {
-                    t %= pt::range;
-                }
-                while ( l < t ) {
-                    l = _umul128 ( rng ( ), pt::range, &h );
-                }
-            }
-            return result_type ( h );
-        }
-        else {
-        #endif
-            using double_width_range_type = typename detail::double_width_integer<range_type>::type;
-            range_type x = rng ( );
-            if ( pt::range >= range_mask ( ) ) {
-                do {
-                    x = rng ( );
-                } while ( x >= pt::range );
-                return result_type ( x );
-            }
-            double_width_range_type m = double_width_range_type ( x ) * double_width_range_type ( pt::range );
-            range_type l = range_type ( m );
-            if ( l < pt::range ) {
-                range_type t = ( 0 - pt::range );
-                t -= pt::range;
-                if ( t >= pt::range ) {
-                    t %= pt::range;
-                }
-                while ( l < t ) {
-                    x = rng ( );
-                    m = double_width_range_type ( x ) * double_width_range_type ( pt::range );
-                    l = range_type ( m );
-                }
-            }
-            return result_type ( m >> std::numeric_limits<range_type>::digits );
-        #if MSVC and M64
-        }
-        #endif
+// Stateless bounded draws for call sites where the range changes on every call (shuffles,
+// graph walks, tree sampling), no param_type is constructed and no threshold is pre-computed.
+// Returns a value in [ 0, n ), n > 0.
+template<typename Gen, typename IntType>
+[[ nodiscard ]] constexpr IntType bounded ( Gen & rng, const IntType n ) NOEXCEPT {
+    static_assert ( detail::is_distribution_result_type<IntType>::value, "only 16-, 32- and 64-bit result_types are allowed." );
+    using range_type = typename std::make_unsigned<IntType>::type;
+    assert ( n > 0 );
+    detail::bits_engine<Gen, range_type, ( Gen::max ( ) < std::numeric_limits<range_type>::max ( ) )> rng_ref ( rng );
+    return static_cast<IntType> ( detail::bounded_lazy<range_type> ( rng_ref, static_cast<range_type> ( n ) ) );
+}
+
+// Returns a value in [ a, b ].
+template<typename Gen, typename IntType>
+[[ nodiscard ]] constexpr IntType bounded ( Gen & rng, const IntType a, const IntType b ) NOEXCEPT {
+    static_assert ( detail::is_distribution_result_type<IntType>::value, "only 16-, 32- and 64-bit result_types are allowed." );
+    using range_type = typename std::make_unsigned<IntType>::type;
+    assert ( b >= a );
+    detail::bits_engine<Gen, range_type, ( Gen::max ( ) < std::numeric_limits<range_type>::max ( ) )> rng_ref ( rng );
+    const range_type range = range_type ( range_type ( b ) - range_type ( a ) + 1 ); // wraps to 0 for the full range.
+    if ( 0 == range ) {
+        return static_cast<IntType> ( rng_ref ( ) );
     }
-};
+    return static_cast<IntType> ( range_type ( detail::bounded_lazy<range_type> ( rng_ref, range ) + range_type ( a ) ) );
+}
 } // namespace ext
 
 
@@ -413,7 +815,7 @@ class uniform_int_distribution_fast : public detail::param_type<IntType, uniform
 
 // macro cleanup
 
-#undef USE_ABSEIL
+#undef HAVE_IS_CONSTANT_EVALUATED
 #undef GNU
 #undef MSVC
 #undef CLANG
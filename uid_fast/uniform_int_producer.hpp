@@ -0,0 +1,285 @@
+
+// MIT License
+//
+// Copyright (c) 2018 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "uniform_int_distribution_fast.hpp"
+
+#if defined ( _WIN32 ) && ! ( defined ( __clang__ ) || defined ( __GNUC__ ) ) // MSVC and not clang or gcc on windows.
+    #define GNU 0
+    #define MSVC 1
+#else
+    #define GNU 1
+    #define MSVC 0
+#endif
+
+#if _HAS_EXCEPTIONS == 0
+    #define NOEXCEPT
+#else
+    #define NOEXCEPT noexcept
+#endif
+
+#if GNU
+    #define COLD __attribute__ ( ( noinline, cold ) )
+    #define LIKELY( x ) __builtin_expect ( !!( x ), 1 )
+#else
+    #define COLD __declspec ( noinline )
+    #define LIKELY( x ) ( x )
+#endif
+
+
+namespace ext {
+
+// Wait-free single-producer / single-consumer ring of fixed-size blocks. The producer fills
+// the block returned by write_block ( ) and publishes it with commit ( ), the consumer reads
+// the block returned by read_block ( ) and hands it back with release ( ).
+template<typename Type, std::size_t BlockSize, std::size_t Blocks>
+class spsc_block_ring {
+
+    static_assert ( Blocks and not ( Blocks & ( Blocks - 1 ) ), "the number of blocks should be a power of 2." );
+
+    public:
+
+    using value_type = Type;
+    using block_type = std::array<value_type, BlockSize>;
+
+    static constexpr std::size_t block_size = BlockSize;
+
+    // Returns nullptr if the ring is full.
+    [[ nodiscard ]] value_type * write_block ( ) NOEXCEPT {
+        const std::size_t t = tail.load ( std::memory_order_relaxed );
+        if ( Blocks == t - head.load ( std::memory_order_acquire ) ) {
+            return nullptr;
+        }
+        return blocks [ t & ( Blocks - 1 ) ].data ( );
+    }
+
+    void commit ( ) NOEXCEPT {
+        tail.store ( tail.load ( std::memory_order_relaxed ) + 1, std::memory_order_release );
+    }
+
+    // Returns nullptr if the ring is empty.
+    [[ nodiscard ]] const value_type * read_block ( ) NOEXCEPT {
+        const std::size_t h = head.load ( std::memory_order_relaxed );
+        if ( h == tail.load ( std::memory_order_acquire ) ) {
+            return nullptr;
+        }
+        return blocks [ h & ( Blocks - 1 ) ].data ( );
+    }
+
+    void release ( ) NOEXCEPT {
+        head.store ( head.load ( std::memory_order_relaxed ) + 1, std::memory_order_release );
+    }
+
+    private:
+
+    alignas ( 64 ) std::atomic<std::size_t> head { 0 }; // written by the consumer.
+    alignas ( 64 ) std::atomic<std::size_t> tail { 0 }; // written by the producer.
+    alignas ( 64 ) std::array<block_type, Blocks> blocks;
+};
+
+
+// A helper thread runs Gen and uniform_int_distribution_fast into pre-reduced blocks, one
+// spsc_block_ring per registered range (channel). The consumer pays a load and a pointer
+// increment per value, if a ring runs dry, the value is generated inline, from the (independent)
+// fallback engine, and the event is counted. All channels are to be drawn from by one and the
+// same consumer thread. Once all rings are full, the helper thread sleeps until the consumer
+// hands back a block (or the producer stops).
+template<typename IntType, typename Gen, std::size_t BlockSize = 512, std::size_t Blocks = 16>
+class uniform_int_producer {
+
+    public:
+
+    using result_type = IntType;
+    using distribution_type = uniform_int_distribution_fast<result_type>;
+    using channel_type = std::size_t;
+
+    private:
+
+    using ring_type = spsc_block_ring<result_type, BlockSize, Blocks>;
+
+    struct channel {
+
+        explicit channel ( result_type a_, result_type b_ ) NOEXCEPT :
+            distribution ( a_, b_ ) { }
+
+        ring_type ring;
+        distribution_type distribution;
+        // Consumer side.
+        alignas ( 64 ) const result_type * pos = nullptr;
+        const result_type * end = nullptr;
+        std::uint64_t blocks = 0, fallbacks = 0;
+    };
+
+    public:
+
+    explicit uniform_int_producer ( const Gen & producer_gen_, const Gen & fallback_gen_ ) :
+        producer_gen ( producer_gen_ ),
+        fallback_gen ( fallback_gen_ ) { }
+
+    uniform_int_producer ( const uniform_int_producer & ) = delete;
+    uniform_int_producer & operator = ( const uniform_int_producer & ) = delete;
+
+    ~uniform_int_producer ( ) {
+        stop ( );
+    }
+
+    // Registers the range [ a, b ], channels are to be added before start ( ).
+    [[ nodiscard ]] channel_type add ( result_type a, result_type b = std::numeric_limits<result_type>::max ( ) ) {
+        assert ( not thread.joinable ( ) );
+        channels.emplace_back ( std::make_unique<channel> ( a, b ) );
+        return channels.size ( ) - 1;
+    }
+
+    void start ( ) {
+        assert ( not thread.joinable ( ) );
+        running.store ( true, std::memory_order_relaxed );
+        thread = std::thread ( [ this ] ( ) { produce ( ); } );
+    }
+
+    void stop ( ) {
+        if ( thread.joinable ( ) ) {
+            {
+                std::lock_guard<std::mutex> lock ( mutex );
+                running.store ( false, std::memory_order_relaxed );
+            }
+            wake.notify_one ( );
+            thread.join ( );
+        }
+    }
+
+    [[ nodiscard ]] result_type operator ( ) ( channel_type c_ ) NOEXCEPT {
+        channel & c = *channels [ c_ ];
+        if ( LIKELY ( c.pos != c.end ) ) {
+            return *c.pos++;
+        }
+        return next_block ( c );
+    }
+
+    // Number of blocks taken from the ring, resp. values generated inline, on channel c_.
+    [[ nodiscard ]] std::uint64_t blocks ( channel_type c_ ) const NOEXCEPT {
+        return channels [ c_ ]->blocks;
+    }
+    [[ nodiscard ]] std::uint64_t fallbacks ( channel_type c_ ) const NOEXCEPT {
+        return channels [ c_ ]->fallbacks;
+    }
+
+    // Whether the helper thread sleeps (all rings full), resp. the number of rounds it made over
+    // the rings, which doesn't change while it sleeps.
+    [[ nodiscard ]] bool asleep ( ) const NOEXCEPT {
+        return sleeping.load ( std::memory_order_relaxed );
+    }
+    [[ nodiscard ]] std::uint64_t rounds ( ) const NOEXCEPT {
+        return round_count.load ( std::memory_order_relaxed );
+    }
+
+    private:
+
+    COLD result_type next_block ( channel & c ) NOEXCEPT {
+        if ( c.end ) {
+            c.ring.release ( );
+            c.pos = c.end = nullptr;
+            std::atomic_thread_fence ( std::memory_order_seq_cst ); // the release before the load of sleeping.
+            if ( sleeping.load ( std::memory_order_relaxed ) ) {
+                {
+                    std::lock_guard<std::mutex> lock ( mutex );
+                    sleeping.store ( false, std::memory_order_relaxed );
+                }
+                wake.notify_one ( );
+            }
+        }
+        if ( const result_type * block = c.ring.read_block ( ); block ) {
+            ++c.blocks;
+            c.pos = block;
+            c.end = block + BlockSize;
+            return *c.pos++;
+        }
+        ++c.fallbacks;
+        return c.distribution ( fallback_gen );
+    }
+
+    void produce ( ) NOEXCEPT {
+        while ( running.load ( std::memory_order_relaxed ) ) {
+            round_count.store ( round_count.load ( std::memory_order_relaxed ) + 1, std::memory_order_relaxed ); // the only writer.
+            bool idle = true;
+            for ( auto & c : channels ) {
+                if ( result_type * block = c->ring.write_block ( ); block ) {
+                    for ( std::size_t i = 0; i < BlockSize; ++i ) {
+                        block [ i ] = c->distribution ( producer_gen );
+                    }
+                    c->ring.commit ( );
+                    idle = false;
+                }
+            }
+            if ( idle ) {
+                sleep ( );
+            }
+        }
+    }
+
+    // Sleeps until a block is released, the rings are checked again after announcing the sleep,
+    // such that a release in between is not missed.
+    COLD void sleep ( ) {
+        std::unique_lock<std::mutex> lock ( mutex );
+        sleeping.store ( true, std::memory_order_relaxed );
+        std::atomic_thread_fence ( std::memory_order_seq_cst ); // the store of sleeping before the loads of the rings.
+        for ( auto & c : channels ) {
+            if ( c->ring.write_block ( ) ) {
+                sleeping.store ( false, std::memory_order_relaxed );
+                return;
+            }
+        }
+        wake.wait ( lock, [ this ] ( ) { return not sleeping.load ( std::memory_order_relaxed ) or not running.load ( std::memory_order_relaxed ); } );
+        sleeping.store ( false, std::memory_order_relaxed );
+    }
+
+    std::vector<std::unique_ptr<channel>> channels;
+    Gen producer_gen, fallback_gen;
+    std::atomic<bool> running { false }, sleeping { false };
+    std::atomic<std::uint64_t> round_count { 0 };
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::thread thread;
+};
+} // namespace ext
+
+
+// macro cleanup
+
+#undef LIKELY
+#undef COLD
+#undef GNU
+#undef MSVC
+#undef NOEXCEPT
@@ -0,0 +1,200 @@
+
+// MIT License
+//
+// Copyright (c) 2018 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <initializer_list>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "uniform_int_distribution_fast.hpp"
+
+#if _HAS_EXCEPTIONS == 0
+    #define NOEXCEPT
+#else
+    #define NOEXCEPT noexcept
+#endif
+
+
+namespace ext {
+
+// Draws uniformly from a union of disjoint closed intervals [ a0, b0 ] u [ a1, b1 ] u ...,
+// f.e. [ a, b ] minus a set of excluded sub-ranges. A single bounded draw is done over the total
+// size of the set, which is then mapped onto its interval, by a branch-free linear count for a
+// few intervals and a binary search otherwise, the latency does not depend on how much of the
+// space is excluded. The set can be updated incrementally with include ( ) and exclude ( ).
+template<typename IntType = int>
+class uniform_interval_distribution {
+
+    static_assert ( detail::is_distribution_result_type<IntType>::value, "only 16-, 32- and 64-bit result_types are allowed." );
+
+    public:
+
+    using result_type = IntType;
+    using interval_type = std::pair<result_type, result_type>;
+
+    private:
+
+    using range_type = typename std::make_unsigned<result_type>::type;
+    using distribution_type = uniform_int_distribution_fast<range_type>;
+
+    static constexpr std::size_t linear_search_max = 16;
+
+    public:
+
+    explicit uniform_interval_distribution ( ) :
+        uniform_interval_distribution ( std::numeric_limits<result_type>::min ( ), std::numeric_limits<result_type>::max ( ) ) { }
+    explicit uniform_interval_distribution ( result_type a, result_type b ) :
+        intervals { { a, b } } {
+        assert ( b >= a );
+        update ( 0 );
+    }
+    // The intervals need not be sorted, overlapping or adjacent intervals are merged.
+    explicit uniform_interval_distribution ( std::initializer_list<interval_type> intervals_ ) :
+        uniform_interval_distribution ( intervals_.begin ( ), intervals_.end ( ) ) { }
+    template<typename It>
+    explicit uniform_interval_distribution ( It first, const It last ) {
+        while ( first != last ) {
+            include ( first->first, first->second );
+            ++first;
+        }
+    }
+
+    void reset ( ) const NOEXCEPT {
+    }
+
+    template<typename Gen>
+    [[ nodiscard ]] result_type operator ( ) ( Gen & rng ) const NOEXCEPT {
+        assert ( not intervals.empty ( ) );
+        const range_type r = distribution ( rng );
+        const std::size_t i = find ( r );
+        return result_type ( range_type ( intervals [ i ].first ) + ( r - offsets [ i ] ) );
+    }
+
+    // Adds [ a, b ] to the set.
+    void include ( result_type a, result_type b ) {
+        assert ( b >= a );
+        const auto lo = std::partition_point ( intervals.begin ( ), intervals.end ( ), [ a ] ( const interval_type & i ) {
+            return i.second < a and not adjacent ( i.second, a );
+        } );
+        const auto hi = std::partition_point ( lo, intervals.end ( ), [ b ] ( const interval_type & i ) {
+            return i.first <= b or adjacent ( b, i.first );
+        } );
+        if ( lo != hi ) {
+            a = std::min ( a, lo->first );
+            b = std::max ( b, ( hi - 1 )->second );
+        }
+        const std::size_t k = lo - intervals.begin ( );
+        intervals.insert ( intervals.erase ( lo, hi ), interval_type { a, b } );
+        update ( k );
+    }
+
+    // Removes [ a, b ] from the set.
+    void exclude ( result_type a, result_type b ) {
+        assert ( b >= a );
+        const auto lo = std::partition_point ( intervals.begin ( ), intervals.end ( ), [ a ] ( const interval_type & i ) {
+            return i.second < a;
+        } );
+        const auto hi = std::partition_point ( lo, intervals.end ( ), [ b ] ( const interval_type & i ) {
+            return i.first <= b;
+        } );
+        if ( lo == hi ) {
+            return;
+        }
+        interval_type pieces [ 2 ];
+        std::size_t n = 0;
+        if ( lo->first < a ) {
+            pieces [ n++ ] = interval_type { lo->first, result_type ( a - 1 ) };
+        }
+        if ( ( hi - 1 )->second > b ) {
+            pieces [ n++ ] = interval_type { result_type ( b + 1 ), ( hi - 1 )->second };
+        }
+        const std::size_t k = lo - intervals.begin ( );
+        intervals.insert ( intervals.erase ( lo, hi ), pieces, pieces + n );
+        update ( k );
+    }
+
+    [[ nodiscard ]] const std::vector<interval_type> & param ( ) const NOEXCEPT {
+        return intervals;
+    }
+
+    // The number of values in the set, 0 signifies all values of result_type.
+    [[ nodiscard ]] range_type size ( ) const NOEXCEPT {
+        return intervals.empty ( ) ? 0 : offsets.back ( ) + length ( intervals.back ( ) );
+    }
+
+    [[ nodiscard ]] bool empty ( ) const NOEXCEPT {
+        return intervals.empty ( );
+    }
+
+    private:
+
+    [[ nodiscard ]] static bool adjacent ( result_type b, result_type a ) NOEXCEPT {
+        return b != std::numeric_limits<result_type>::max ( ) and result_type ( b + 1 ) == a;
+    }
+
+    [[ nodiscard ]] static range_type length ( const interval_type & i ) NOEXCEPT {
+        return range_type ( i.second ) - range_type ( i.first ) + 1; // wraps to 0 for all values.
+    }
+
+    [[ nodiscard ]] std::size_t find ( const range_type r ) const NOEXCEPT {
+        if ( offsets.size ( ) <= linear_search_max ) {
+            std::size_t i = 0;
+            for ( std::size_t j = 1; j < offsets.size ( ); ++j ) {
+                i += offsets [ j ] <= r;
+            }
+            return i;
+        }
+        return std::upper_bound ( offsets.begin ( ) + 1, offsets.end ( ), r ) - offsets.begin ( ) - 1;
+    }
+
+    // Recomputes the offsets from interval k onwards.
+    void update ( std::size_t k ) {
+        offsets.resize ( intervals.size ( ) );
+        range_type o = k ? offsets [ k - 1 ] + length ( intervals [ k - 1 ] ) : 0;
+        for ( ; k < intervals.size ( ); ++k ) {
+            offsets [ k ] = o;
+            o += length ( intervals [ k ] );
+        }
+        if ( not intervals.empty ( ) ) {
+            distribution = distribution_type ( 0, range_type ( o - 1 ) );
+        }
+    }
+
+    std::vector<interval_type> intervals;
+    std::vector<range_type> offsets;
+    distribution_type distribution;
+};
+} // namespace ext
+
+
+// macro cleanup
+
+#undef NOEXCEPT
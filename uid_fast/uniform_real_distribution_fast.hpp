@@ -0,0 +1,287 @@
+
+// MIT License
+//
+// C++17-compliant uniform_real_distribution_fast, the floating point companion of
+// uniform_int_distribution_fast. Values in [ 0, 1 ) are built directly from the top bits of
+// the engine output, by multiplication with 2^-53 (resp. 2^-24), or, in dense mode, from a
+// geometrically distributed exponent and a full mantissa:
+// http://allendowney.com/research/rand/downey07randfloat.pdf
+//
+// Copyright (c) 2018 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+
+#include "uniform_int_distribution_fast.hpp"
+
+#if _HAS_EXCEPTIONS == 0
+    #define NOEXCEPT
+#else
+    #define NOEXCEPT noexcept
+#endif
+
+
+namespace ext {
+
+template<typename RealType = double, bool Dense = false>
+class uniform_real_distribution_fast;
+
+namespace detail {
+
+template<typename RealType>
+struct real_traits { };
+template<> struct real_traits<float> {
+    using bits_type = std::uint32_t;
+    static constexpr int mantissa_digits = 24; // including the implicit bit.
+    static constexpr int exponent_bias = 127;
+};
+template<> struct real_traits<double> {
+    using bits_type = std::uint64_t;
+    static constexpr int mantissa_digits = 53;
+    static constexpr int exponent_bias = 1023;
+};
+
+// Returns the top mantissa_digits bits of x, times 2^-mantissa_digits, a value in [ 0, 1 ).
+template<typename RealType>
+[[ nodiscard ]] inline RealType canonical ( std::uint64_t x ) NOEXCEPT {
+    constexpr int digits = real_traits<RealType>::mantissa_digits;
+    return RealType ( x >> ( 64 - digits ) ) * ( RealType { 1 } / RealType ( std::uint64_t { 1 } << digits ) );
+}
+
+// As canonical ( ), for the top 32 bits of x (float only), allowing to split one 64-bit word into two floats.
+[[ nodiscard ]] inline float canonical_32 ( std::uint32_t x ) NOEXCEPT {
+    return float ( x >> 8 ) * ( 1.0f / float ( 1u << 24 ) );
+}
+
+// Dense mode, every representable value in [ 0, 1 ) is produced with the probability of the
+// interval it rounds down from, also the small values near 0. The exponent is the number of
+// leading zeros of an (unbounded) bit stream, starting with the low bits of the first word,
+// the mantissa is taken from its top bits, the two are composed by bit-cast. Takes a second
+// word in only 1 in 2^12 (double) resp. 2^41 (float) cases.
+template<typename RealType, typename Rng>
+[[ nodiscard ]] RealType canonical_dense ( Rng & rng ) NOEXCEPT {
+    using traits = real_traits<RealType>;
+    using bits_type = typename traits::bits_type;
+    constexpr int mantissa_bits = traits::mantissa_digits - 1;
+    constexpr int exponent_bits = 64 - mantissa_bits; // the low bits of the first word determine the exponent.
+    std::uint64_t x = rng ( );
+    const bits_type mantissa = bits_type ( x >> exponent_bits );
+    std::uint64_t e = x & ( ( std::uint64_t { 1 } << exponent_bits ) - 1 );
+    int exponent = traits::exponent_bias - 1;
+    if ( e ) {
+        exponent -= static_cast<int> ( leading_zeros<std::uint64_t> ( e ) ) - mantissa_bits;
+    }
+    else {
+        exponent -= exponent_bits;
+        while ( not ( e = rng ( ) ) ) {
+            exponent -= 64;
+            if ( exponent <= 0 ) {
+                return RealType { 0 };
+            }
+        }
+        exponent -= static_cast<int> ( leading_zeros<std::uint64_t> ( e ) );
+    }
+    if ( exponent <= 0 ) {
+        return RealType { 0 };
+    }
+    const bits_type bits = ( bits_type ( exponent ) << mantissa_bits ) | mantissa;
+    RealType r;
+    std::memcpy ( &r, &bits, sizeof ( r ) );
+    return r;
+}
+} // namespace detail
+
+
+template<typename RealType, bool Dense>
+class uniform_real_distribution_fast {
+
+    static_assert ( std::is_same<RealType, float>::value or std::is_same<RealType, double>::value, "only float and double result_types are allowed." );
+
+    public:
+
+    using result_type = RealType;
+
+    struct param_type {
+
+        using distribution_type = uniform_real_distribution_fast;
+
+        explicit param_type ( result_type a_ = result_type { 0 }, result_type b_ = result_type { 1 } ) NOEXCEPT :
+            a_value ( a_ ),
+            b_value ( b_ ) { }
+
+        [[ nodiscard ]] bool operator == ( const param_type & rhs ) const NOEXCEPT {
+            return ( a_value == rhs.a_value ) and ( b_value == rhs.b_value );
+        }
+
+        [[ nodiscard ]] bool operator != ( const param_type & rhs ) const NOEXCEPT {
+            return not ( *this == rhs );
+        }
+
+        [[ nodiscard ]] result_type a ( ) const NOEXCEPT {
+            return a_value;
+        }
+
+        [[ nodiscard ]] result_type b ( ) const NOEXCEPT {
+            return b_value;
+        }
+
+        private:
+
+        result_type a_value, b_value;
+    };
+
+    private:
+
+    template<typename Gen>
+    using generator_reference = detail::bits_engine<Gen, std::uint64_t, ( Gen::max ( ) < std::numeric_limits<std::uint64_t>::max ( ) )>;
+
+    public:
+
+    explicit uniform_real_distribution_fast ( ) NOEXCEPT :
+        uniform_real_distribution_fast ( param_type ( ) ) { }
+    explicit uniform_real_distribution_fast ( result_type a, result_type b = result_type { 1 } ) NOEXCEPT :
+        uniform_real_distribution_fast ( param_type ( a, b ) ) { }
+    explicit uniform_real_distribution_fast ( const param_type & params_ ) NOEXCEPT :
+        params ( params_ ),
+        scale ( params_.b ( ) - params_.a ( ) ) {
+        assert ( params_.a ( ) < params_.b ( ) );
+    }
+
+    void reset ( ) const NOEXCEPT {
+    }
+
+    template<typename Gen>
+    [[ nodiscard ]] result_type operator ( ) ( Gen & rng ) const NOEXCEPT {
+        generator_reference<Gen> rng_ref ( rng );
+        return transform ( draw ( rng_ref ) );
+    }
+
+    // Fills [ first, last ), the engine words are generated per block (in bulk where the engine
+    // has generate ( )) and converted in a loop that vectorizes, floats take two per 64-bit word.
+    template<typename Gen, typename It>
+    void generate ( Gen & rng, It first, const It last ) const NOEXCEPT {
+        if constexpr ( Dense ) {
+            generator_reference<Gen> rng_ref ( rng );
+            while ( first != last ) {
+                *first++ = transform ( detail::canonical_dense<result_type> ( rng_ref ) );
+            }
+        }
+        else {
+            constexpr std::size_t block_size = 64, per_word = std::is_same<result_type, float>::value ? 2 : 1;
+            constexpr bool full_width_gen = std::is_same<typename Gen::result_type, std::uint64_t>::value and
+                                            ( Gen::min ( ) == 0 ) and ( Gen::max ( ) == std::numeric_limits<std::uint64_t>::max ( ) );
+            generator_reference<Gen> rng_ref ( rng );
+            std::uint64_t x [ block_size ];
+            result_type r [ block_size * per_word ];
+            std::size_t n = std::distance ( first, last );
+            while ( n ) {
+                const std::size_t m = std::min ( n, block_size * per_word ), w = ( m + per_word - 1 ) / per_word;
+                if constexpr ( full_width_gen ) {
+                    detail::generate ( rng, x, x + w );
+                }
+                else {
+                    for ( std::size_t i = 0; i < w; ++i ) {
+                        x [ i ] = rng_ref ( );
+                    }
+                }
+                if constexpr ( per_word == 2 ) {
+                    for ( std::size_t i = 0; i < w; ++i ) {
+                        r [ 2 * i ] = params.a ( ) + scale * detail::canonical_32 ( std::uint32_t ( x [ i ] >> 32 ) );
+                        r [ 2 * i + 1 ] = params.a ( ) + scale * detail::canonical_32 ( std::uint32_t ( x [ i ] ) );
+                    }
+                }
+                else {
+                    for ( std::size_t i = 0; i < w; ++i ) {
+                        r [ i ] = params.a ( ) + scale * detail::canonical<result_type> ( x [ i ] );
+                    }
+                }
+                for ( std::size_t i = 0; i < m; ++i ) {
+                    *first++ = clamp ( r [ i ] );
+                }
+                n -= m;
+            }
+        }
+    }
+
+    [[ nodiscard ]] result_type a ( ) const NOEXCEPT {
+        return params.a ( );
+    }
+
+    [[ nodiscard ]] result_type b ( ) const NOEXCEPT {
+        return params.b ( );
+    }
+
+    [[ nodiscard ]] result_type min ( ) const NOEXCEPT {
+        return params.a ( );
+    }
+
+    [[ nodiscard ]] result_type max ( ) const NOEXCEPT {
+        return params.b ( );
+    }
+
+    [[ nodiscard ]] param_type param ( ) const NOEXCEPT {
+        return params;
+    }
+
+    void param ( const param_type & params_ ) NOEXCEPT {
+        *this = uniform_real_distribution_fast ( params_ );
+    }
+
+    private:
+
+    template<typename Rng>
+    [[ nodiscard ]] result_type draw ( Rng & rng ) const NOEXCEPT {
+        if constexpr ( Dense ) {
+            return detail::canonical_dense<result_type> ( rng );
+        }
+        else {
+            return detail::canonical<result_type> ( rng ( ) );
+        }
+    }
+
+    // a + ( b - a ) * u can round up to b, in which case the largest value below b is returned.
+    [[ nodiscard ]] result_type clamp ( result_type r ) const NOEXCEPT {
+        return r < params.b ( ) ? r : std::nextafter ( params.b ( ), params.a ( ) );
+    }
+
+    [[ nodiscard ]] result_type transform ( result_type u ) const NOEXCEPT {
+        return clamp ( params.a ( ) + scale * u );
+    }
+
+    param_type params;
+    result_type scale;
+};
+} // namespace ext
+
+
+// macro cleanup
+
+#undef NOEXCEPT
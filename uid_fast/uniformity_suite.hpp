@@ -0,0 +1,308 @@
+
+// MIT License
+//
+// Copyright (c) 2018 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <ostream>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "bucket_test.hpp"
+#include "statistics.hpp"
+
+
+// A streaming suite of uniformity tests, over draws draws (of options) from a distribution
+// over [ 0, range ) of width-bit integers, in bounded memory, the draws are generated in the
+// chunks (and streams) of the bucket test, every thread tallies into its own (fixed-size)
+// tally, the tallies are summed. The tests, with their p-values:
+//
+//   chi-squared - the frequencies of (at most 2^16) bins, by the high bits of the draws.
+//   ks          - Kolmogorov-Smirnov, the largest deviation of the empirical CDF of a sample of
+//                 (at most 2^20) raw draws, the first ones of every chunk, from the CDF of the
+//                 discrete uniform distribution, the p-value of the (continuous) Kolmogorov
+//                 distribution is conservative for a discrete one, exact as the range grows.
+//   gap         - the lengths of the gaps between draws in [ 0, range / 8 ) (Knuth 3.3.2 D).
+//   serial      - the frequencies of (non-overlapping) pairs of draws, over (at most) 64 x 64 bins.
+//   threshold   - the frequency of draws below 2^width % range, a modulo reduction without (or
+//                 with a faulty) rejection favours those.
+//   parity      - the frequencies of even and odd draws, per (one of at most 64) bins, a
+//                 multiplication without (or with a faulty) rejection favours every other
+//                 value (over stretches of the range), f.e. at a range near 2^width * 2 / 3.
+//
+// The probes, ranges just beyond 2^( width - 1 ), at 2^width * 2 / 3 and at 2^width - 1, have
+// the largest possible bias (in the absence of rejection), i.e. target the threshold logic.
+namespace bt {
+
+inline constexpr std::size_t suite_max_bins = std::size_t { 1 } << 16, suite_max_pair_bins = 64, suite_gap_limit = 32, suite_ks_sample = std::size_t { 1 } << 20;
+inline constexpr double suite_alpha = 1e-6; // the p-value below which a result is suspect.
+
+// The binning of a range (of draws of width-bit integers).
+struct suite_layout {
+
+    suite_layout ( int width_, std::uint64_t range_ ) noexcept :
+        range ( range_ ),
+        width ( width_ ) {
+        while ( ( ( range - 1 ) >> shift ) >= suite_max_bins ) {
+            ++shift;
+        }
+        while ( ( ( range - 1 ) >> pair_shift ) >= suite_max_pair_bins ) {
+            ++pair_shift;
+        }
+        bins = static_cast<std::size_t> ( ( range - 1 ) >> shift ) + 1;
+        pair_bins = static_cast<std::size_t> ( ( range - 1 ) >> pair_shift ) + 1;
+        gap_end = std::max ( range / 8, std::uint64_t { 1 } );
+        // 2^width % range.
+        threshold = 64 == width ? ( 0 - range ) % range : ( std::uint64_t { 1 } << width ) % range;
+    }
+
+    // The number of values in bin b (of bins of 2^s values).
+    [[ nodiscard ]] double size ( std::size_t b, int s ) const noexcept {
+        const std::uint64_t first = std::uint64_t { b } << s;
+        return static_cast<double> ( std::min ( range - first, std::uint64_t { 1 } << s ) );
+    }
+
+    // The number of odd values in bin b (of bins of 2^s values).
+    [[ nodiscard ]] double odd ( std::size_t b, int s ) const noexcept {
+        const std::uint64_t first = std::uint64_t { b } << s, last = first + std::min ( range - first, std::uint64_t { 1 } << s ) - 1;
+        return static_cast<double> ( last / 2 + ( last & 1 ) - first / 2 );
+    }
+
+    std::uint64_t range;
+    int width, shift = 0, pair_shift = 0;
+    std::size_t bins = 0, pair_bins = 0;
+    std::uint64_t gap_end = 1, threshold = 0;
+};
+
+// The tally of (a share of) the draws.
+struct suite_tally {
+
+    explicit suite_tally ( const suite_layout & l ) :
+        bins ( l.bins, 0 ),
+        pairs ( l.pair_bins * l.pair_bins, 0 ),
+        parities ( l.pair_bins * 2, 0 ) { }
+
+    // Tallies the draws of one chunk, in [ values, values + n ), n even (but for the last).
+    void operator ( ) ( const suite_layout & l, const std::uint64_t * values, std::size_t n, std::uint64_t & gap ) noexcept {
+        for ( std::size_t i = 0; i < n; ++i ) {
+            const std::uint64_t x = values [ i ];
+            ++bins [ static_cast<std::size_t> ( x >> l.shift ) ];
+            below += x < l.threshold;
+            ++parities [ static_cast<std::size_t> ( x >> l.pair_shift ) * 2 + static_cast<std::size_t> ( x & 1 ) ];
+            if ( x < l.gap_end ) {
+                ++gaps [ std::min ( gap, std::uint64_t { suite_gap_limit } ) ];
+                gap = 0;
+            }
+            else {
+                ++gap;
+            }
+        }
+        for ( std::size_t i = 0; i + 1 < n; i += 2 ) {
+            ++pairs [ static_cast<std::size_t> ( values [ i ] >> l.pair_shift ) * l.pair_bins + static_cast<std::size_t> ( values [ i + 1 ] >> l.pair_shift ) ];
+        }
+        draws += n;
+    }
+
+    void merge ( const suite_tally & other_ ) noexcept {
+        std::transform ( bins.begin ( ), bins.end ( ), other_.bins.begin ( ), bins.begin ( ), std::plus<counter_type> ( ) );
+        std::transform ( pairs.begin ( ), pairs.end ( ), other_.pairs.begin ( ), pairs.begin ( ), std::plus<counter_type> ( ) );
+        std::transform ( gaps.begin ( ), gaps.end ( ), other_.gaps.begin ( ), gaps.begin ( ), std::plus<counter_type> ( ) );
+        draws += other_.draws;
+        below += other_.below;
+        std::transform ( parities.begin ( ), parities.end ( ), other_.parities.begin ( ), parities.begin ( ), std::plus<counter_type> ( ) );
+        sample.insert ( sample.end ( ), other_.sample.begin ( ), other_.sample.end ( ) );
+    }
+
+    std::vector<counter_type> bins, pairs, parities;
+    std::vector<std::uint64_t> sample; // the raw draws of the ks test, in no particular order.
+    std::array<counter_type, suite_gap_limit + 1> gaps { }; // gaps of 0, 1, ..., limit - 1 and limit or longer.
+    counter_type draws = 0, below = 0;
+};
+
+// Returns the chi-squared statistic and its degrees of freedom of the observed counts against
+// the expected counts, adjacent cells are pooled until they expect at least 5.
+template<typename Expected>
+[[ nodiscard ]] std::pair<double, double> chi_squared ( const counter_type * observed, std::size_t cells, Expected expected ) {
+    double chi = 0.0, o = 0.0, e = 0.0, last_o = 0.0, last_e = 0.0;
+    std::size_t pooled = 0;
+    for ( std::size_t i = 0; i < cells; ++i ) {
+        o += static_cast<double> ( observed [ i ] );
+        e += expected ( i );
+        if ( e >= 5.0 ) {
+            chi += ( o - e ) * ( o - e ) / e;
+            last_o = o, last_e = e;
+            o = e = 0.0;
+            ++pooled;
+        }
+    }
+    if ( e > 0.0 and pooled ) { // the remainder joins the last cell.
+        chi += ( last_o + o - last_e - e ) * ( last_o + o - last_e - e ) / ( last_e + e ) - ( last_o - last_e ) * ( last_o - last_e ) / last_e;
+    }
+    return { chi, static_cast<double> ( std::max ( pooled, std::size_t { 2 } ) - 1 ) };
+}
+
+struct suite_result {
+
+    [[ nodiscard ]] double min_p ( ) const noexcept {
+        double p = 1.0;
+        for ( const double q : { chi_squared, ks, gap, serial, threshold, parity } ) {
+            if ( not std::isnan ( q ) ) {
+                p = std::min ( p, q );
+            }
+        }
+        return p;
+    }
+
+    std::string_view distribution;
+    int width = 64;
+    std::uint64_t range = 0, draws = 0;
+    // The p-values of the tests, nan if not applicable.
+    double chi_squared = 0.0, ks = 0.0, gap = 0.0, serial = 0.0, threshold = 0.0, parity = 0.0;
+};
+
+// Runs the suite for the kernel over [ 0, range ) of width-bit integers.
+[[ nodiscard ]] inline suite_result test ( const options & o, kernel_type kernel, int width, std::uint64_t range ) {
+    const suite_layout l ( width, range );
+    std::vector<generator> streams = split ( o );
+    const std::uint64_t chunks = streams.size ( );
+    const unsigned threads = thread_count ( o, chunks );
+    std::vector<suite_tally> tallies ( threads, suite_tally ( l ) );
+    const std::uint64_t sample_per_chunk = ( suite_ks_sample + chunks - 1 ) / chunks; // the same sample for any number of threads.
+    std::atomic<std::uint64_t> next { 0 };
+    parallel ( threads, [ & ] ( unsigned t ) {
+        std::vector<std::uint64_t> values ( partition_block );
+        for ( std::uint64_t c; ( c = next.fetch_add ( 1, std::memory_order_relaxed ) ) < chunks; ) {
+            std::uint64_t gap = 0, sampled = 0; // gaps don't span chunks.
+            for ( std::uint64_t left = std::min ( o.chunk, o.draws - c * o.chunk ); left; ) {
+                const std::size_t n = static_cast<std::size_t> ( std::min<std::uint64_t> ( left, partition_block ) );
+                left -= n;
+                kernel.fill ( streams [ c ], range, n, values.data ( ) );
+                tallies [ t ] ( l, values.data ( ), n, gap );
+                const std::size_t m = static_cast<std::size_t> ( std::min<std::uint64_t> ( n, sample_per_chunk - sampled ) );
+                tallies [ t ].sample.insert ( tallies [ t ].sample.end ( ), values.begin ( ), values.begin ( ) + m );
+                sampled += m;
+            }
+        }
+    } );
+    for ( unsigned t = 1; t < threads; ++t ) {
+        tallies [ 0 ].merge ( tallies [ t ] );
+    }
+    suite_tally & s = tallies [ 0 ];
+    const double n = static_cast<double> ( s.draws ), r = static_cast<double> ( range );
+    suite_result result;
+    result.width = width, result.range = range, result.draws = s.draws;
+    {
+        const auto [ chi, df ] = chi_squared ( s.bins.data ( ), l.bins, [ & ] ( std::size_t b ) { return n * l.size ( b, l.shift ) / r; } );
+        result.chi_squared = sf::chi_squared_p ( chi, df );
+    }
+    {
+        // The empirical CDF steps at the sampled values v, from below v (against F ( v - 1 ) = v / r)
+        // to at v (against F ( v ) = ( v + 1 ) / r), in between it is constant.
+        std::sort ( s.sample.begin ( ), s.sample.end ( ) );
+        const double m = static_cast<double> ( s.sample.size ( ) );
+        double d = 0.0;
+        for ( std::size_t i = 0; i < s.sample.size ( ); ) {
+            const std::uint64_t v = s.sample [ i ];
+            const double below = static_cast<double> ( i ) / m;
+            while ( i < s.sample.size ( ) and s.sample [ i ] == v ) {
+                ++i;
+            }
+            d = std::max ( { d, std::abs ( below - static_cast<double> ( v ) / r ), std::abs ( static_cast<double> ( i ) / m - ( static_cast<double> ( v ) + 1.0 ) / r ) } );
+        }
+        result.ks = m > 0.0 ? sf::kolmogorov_smirnov_p ( d, m ) : std::numeric_limits<double>::quiet_NaN ( );
+    }
+    {
+        const double p = static_cast<double> ( l.gap_end ) / r;
+        counter_type gaps = 0;
+        for ( const counter_type g : s.gaps ) {
+            gaps += g;
+        }
+        const auto [ chi, df ] = chi_squared ( s.gaps.data ( ), s.gaps.size ( ), [ & ] ( std::size_t k ) {
+            return static_cast<double> ( gaps ) * ( suite_gap_limit == k ? std::pow ( 1.0 - p, k ) : p * std::pow ( 1.0 - p, k ) );
+        } );
+        result.gap = gaps ? sf::chi_squared_p ( chi, df ) : std::numeric_limits<double>::quiet_NaN ( );
+    }
+    {
+        const double pairs = static_cast<double> ( std::accumulate ( s.pairs.begin ( ), s.pairs.end ( ), counter_type { 0 } ) );
+        const auto [ chi, df ] = chi_squared ( s.pairs.data ( ), s.pairs.size ( ), [ & ] ( std::size_t i ) {
+            return pairs * ( l.size ( i / l.pair_bins, l.pair_shift ) / r ) * ( l.size ( i % l.pair_bins, l.pair_shift ) / r );
+        } );
+        result.serial = pairs > 0.0 and l.pair_bins > 1 ? sf::chi_squared_p ( chi, df ) : std::numeric_limits<double>::quiet_NaN ( );
+    }
+    const auto z = [ n ] ( double observed, double p ) {
+        return p > 0.0 and p < 1.0 ? sf::normal_p ( ( observed - n * p ) / std::sqrt ( n * p * ( 1.0 - p ) ) ) : std::numeric_limits<double>::quiet_NaN ( );
+    };
+    result.threshold = z ( static_cast<double> ( s.below ), static_cast<double> ( l.threshold ) / r );
+    {
+        const auto [ chi, df ] = chi_squared ( s.parities.data ( ), s.parities.size ( ), [ & ] ( std::size_t i ) {
+            const double odd = l.odd ( i / 2, l.pair_shift );
+            return n * ( i & 1 ? odd : l.size ( i / 2, l.pair_shift ) - odd ) / r;
+        } );
+        result.parity = range > 1 ? sf::chi_squared_p ( chi, df ) : std::numeric_limits<double>::quiet_NaN ( );
+    }
+    return result;
+}
+
+// The ranges of the suite at a width, some ordinary ones and the probes.
+[[ nodiscard ]] inline std::vector<std::uint64_t> suite_ranges ( int width ) {
+    const std::uint64_t top = 64 == width ? std::numeric_limits<std::uint64_t>::max ( ) : ( std::uint64_t { 1 } << width ) - 1; // 2^width - 1.
+    return {
+        6, 1'000, ( std::uint64_t { 1 } << ( width / 2 ) ) + 1,
+        ( std::uint64_t { 1 } << ( width - 1 ) ) + 1, top / 3 * 2, top
+    };
+}
+
+inline void report_header ( std::ostream & out ) {
+    out << "distribution      width                range  chi-squared           ks          gap       serial    threshold       parity\n";
+}
+
+inline void report ( std::ostream & out, const suite_result & r ) {
+    const auto flags = out.flags ( );
+    const auto precision = out.precision ( 4 );
+    out.width ( 17 ), out << std::left << r.distribution << std::right;
+    out.width ( 6 ), out << r.width;
+    out.width ( 21 ), out << r.range;
+    for ( const double p : { r.chi_squared, r.ks, r.gap, r.serial, r.threshold, r.parity } ) {
+        out.width ( 13 );
+        if ( std::isnan ( p ) ) {
+            out << '-';
+        }
+        else {
+            out << p;
+        }
+    }
+    out << ( r.min_p ( ) < suite_alpha ? "  suspect\n" : "\n" );
+    out.precision ( precision );
+    out.flags ( flags );
+}
+} // namespace bt